@@ -0,0 +1,433 @@
+/*
+    boaa.cpp
+    10/16/26
+
+    benchmark: OAA (pointer nodes) against CompactOAA (index nodes) and
+    FrozenOAA (Eytzinger array snapshot)
+
+    For each table it reports the bytes of node storage per node (not
+    counting the separate character blocks of String keys) and the
+    nanoseconds per operation of
+      insert   Increment of every key in input order
+      find     Find of every key in a shuffled order, rounds times over
+      rehashed find again after Rehash()
+    For FrozenOAA (OAA::Freeze()) insert is the time of Freeze() per entry
+    and rehashed does not apply. A further line compares looped Find and
+    Get with OAA::FindBatch and OAA::GetBatch over the same probes, and for
+    int keys the last lines time sorted batches of new pairs through looped
+    Put and through OAA::InsertSorted, and the combining of 8 partial tables
+    by iterating and Incrementing against OAA::Merge. The copy line times a
+    copy of the whole table and then one Increment of a random key after
+    each fresh copy, for OAA (a deep copy) and PersistentOAA (a shared root
+    and a copied path). The threads line has 4 threads Increment the keys,
+    dealt round robin, into one OAA behind a mutex and into a ShardedOAA.
+    For a text file the count line does the same with the words against a
+    HashCounter, and also times HashCounter::LoadInto, which makes the
+    ordered table.
+
+    Keys are the whitespace separated tokens of a text file (not Wordified),
+    as fsu::String and as InlineString keys, or n random ints.
+
+    usage:  boaa.x n [rounds]          random int keys
+            boaa.x filename [rounds]   words of a file
+*/
+
+#include <algorithm>  // min, sort
+#include <chrono>
+#include <cstdlib>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <xstring.h>
+#include <xstring.cpp>  // in lieu of makefile
+#include <oaa.h>
+#include <coaa.h>
+#include <frozenoaa.h>
+#include <poaa.h>
+#include <shardedoaa.h>
+#include <hashcount.h>
+#include <inlstr.h>
+
+typedef std::chrono::steady_clock Clock;
+
+double NsPer (Clock::time_point start, size_t ops)
+{
+  std::chrono::duration<double, std::nano> d = Clock::now() - start;
+  return ops == 0 ? 0.0 : d.count() / ops;
+}
+
+template < class T , class K >
+void Bench (const char* name, const std::vector<K>& keys, const std::vector<K>& probes, size_t rounds)
+{
+  T table;
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < keys.size(); ++i)
+    table.Increment(keys[i]);
+  double insert = NsPer(start, keys.size());
+
+  size_t hits = 0;
+  start = Clock::now();
+  for (size_t r = 0; r < rounds; ++r)
+    for (size_t i = 0; i < probes.size(); ++i)
+      hits += (table.Find(probes[i]) != nullptr);
+  double find = NsPer(start, rounds * probes.size());
+
+  table.Rehash();
+  start = Clock::now();
+  for (size_t r = 0; r < rounds; ++r)
+    for (size_t i = 0; i < probes.size(); ++i)
+      hits += (table.Find(probes[i]) != nullptr);
+  double rehashed = NsPer(start, rounds * probes.size());
+
+  std::cout << "  " << std::setw(12) << std::left << name << std::right
+            << std::setw(9) << table.Size()
+            << std::setw(12) << std::setprecision(1) << std::fixed
+            << (double)table.BytesInUse() / table.NumNodes()
+            << std::setw(10) << insert
+            << std::setw(10) << find
+            << std::setw(10) << rehashed
+            << "   (" << hits << " hits)\n";
+}
+
+template < class T , class K >
+void BenchFrozen (const char* name, const std::vector<K>& keys, const std::vector<K>& probes, size_t rounds)
+{
+  T table;
+  for (size_t i = 0; i < keys.size(); ++i)
+    table.Increment(keys[i]);
+  Clock::time_point start = Clock::now();
+  auto frozen = table.Freeze();
+  double freeze = NsPer(start, frozen.Size());
+
+  size_t hits = 0;
+  start = Clock::now();
+  for (size_t r = 0; r < rounds; ++r)
+    for (size_t i = 0; i < probes.size(); ++i)
+      hits += (frozen.Find(probes[i]) != nullptr);
+  double find = NsPer(start, rounds * probes.size());
+
+  std::cout << "  " << std::setw(12) << std::left << name << std::right
+            << std::setw(9) << frozen.Size()
+            << std::setw(12) << std::setprecision(1) << std::fixed
+            << (double)frozen.BytesInUse() / (frozen.Size() + 1)
+            << std::setw(10) << freeze
+            << std::setw(10) << find
+            << std::setw(10) << "-"
+            << "   (" << hits << " hits)\n";
+}
+
+template < class T , class K >
+void BenchBatch (const std::vector<K>& keys, const std::vector<K>& probes, size_t rounds)
+// looped Find/Get against FindBatch/GetBatch on one OAA, in chunks of Chunk keys
+{
+  const size_t Chunk = 256;
+  T table;
+  for (size_t i = 0; i < keys.size(); ++i)
+    table.Increment(keys[i]);
+  std::vector<const typename T::DataType*> found(Chunk);
+  std::vector<typename T::DataType*> got(Chunk);
+  size_t ops = rounds * probes.size(), sum = 0;
+
+  Clock::time_point start = Clock::now();
+  for (size_t r = 0; r < rounds; ++r)
+    for (size_t i = 0; i < probes.size(); ++i)
+      sum += (table.Find(probes[i]) != nullptr);
+  double find = NsPer(start, ops);
+
+  start = Clock::now();
+  for (size_t r = 0; r < rounds; ++r)
+    for (size_t i = 0; i < probes.size(); i += Chunk)
+    {
+      size_t m = std::min(Chunk, probes.size() - i);
+      table.FindBatch(&probes[i], m, &found[0]);
+      for (size_t j = 0; j < m; ++j)
+        sum += (found[j] != nullptr);
+    }
+  double findBatch = NsPer(start, ops);
+
+  start = Clock::now();
+  for (size_t r = 0; r < rounds; ++r)
+    for (size_t i = 0; i < probes.size(); ++i)
+      sum += table.Get(probes[i]);
+  double get = NsPer(start, ops);
+
+  start = Clock::now();
+  for (size_t r = 0; r < rounds; ++r)
+    for (size_t i = 0; i < probes.size(); i += Chunk)
+    {
+      size_t m = std::min(Chunk, probes.size() - i);
+      table.GetBatch(&probes[i], m, &got[0]);
+      for (size_t j = 0; j < m; ++j)
+        sum += *got[j];
+    }
+  double getBatch = NsPer(start, ops);
+
+  std::cout << std::setprecision(1) << std::fixed
+            << "  OAA batched (ns/op)   Find " << find << "  FindBatch " << findBatch
+            << "   Get " << get << "  GetBatch " << getBatch
+            << "   (" << sum << ")\n";
+}
+
+template < class T , class K >
+void BenchSorted (const std::vector<K>& keys, size_t m)
+// m sorted new pairs into a table of keys: looped Put against InsertSorted
+{
+  T a, b;
+  for (size_t i = 0; i < keys.size(); ++i)
+    a.Put(keys[i], 1);
+  b = a;
+  std::vector< std::pair<K,typename T::DataType> > batch(m);
+  for (size_t i = 0; i < m; ++i)
+    batch[i] = std::make_pair((K)std::rand(), 1);
+  std::sort(batch.begin(), batch.end());
+
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < m; ++i)
+    a.Put(batch[i].first, batch[i].second);
+  double put = NsPer(start, m);
+
+  start = Clock::now();
+  b.InsertSorted(batch.begin(), batch.end());
+  double sorted = NsPer(start, m);
+
+  std::cout << std::setprecision(1) << std::fixed
+            << "  OAA sorted batch of " << m << " (ns/key)   Put " << put
+            << "  InsertSorted " << sorted
+            << "   (" << a.Size() << ' ' << b.Size() << ")\n";
+}
+
+template < class T , class K >
+void BenchMerge (const std::vector<K>& keys, size_t parts)
+// keys dealt into parts tables, combined by Traverse-and-Increment and by Merge
+{
+  std::vector<T> a(parts), b(parts);
+  for (size_t i = 0; i < keys.size(); ++i)
+    a[i % parts].Increment(keys[i]);
+  for (size_t i = 0; i < parts; ++i)
+    b[i] = a[i];
+
+  Clock::time_point start = Clock::now();
+  T x;
+  for (size_t i = 0; i < parts; ++i)
+    for (typename T::ConstIterator j = a[i].Begin(); j != a[i].End(); ++j)
+      x.Increment(j.Key(), j.Data());
+  double get = NsPer(start, keys.size());
+
+  start = Clock::now();
+  T y;
+  for (size_t i = 0; i < parts; ++i)
+    y.Merge(std::move(b[i]), fsu::Accumulate<typename T::DataType>());
+  double merge = NsPer(start, keys.size());
+
+  std::cout << std::setprecision(1) << std::fixed
+            << "  OAA merge of " << parts << " tables (ns/key)   Increment " << get
+            << "  Merge " << merge
+            << "   (" << x.Size() << ' ' << y.Size() << ")\n";
+}
+
+template < class T , class K >
+void BenchCopy (const char* name, const std::vector<K>& keys, size_t copies)
+// copies of a full table, each followed by one change to the original
+{
+  T table;
+  for (size_t i = 0; i < keys.size(); ++i)
+    table.Increment(keys[i]);
+  size_t sum = 0;
+
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < copies; ++i)
+  {
+    T copy(table);
+    sum += copy.Size();
+  }
+  double copy = NsPer(start, copies);
+
+  std::vector<T> snaps;
+  snaps.reserve(copies);
+  double change = 0.0;
+  for (size_t i = 0; i < copies; ++i)
+  {
+    snaps.push_back(table);
+    start = Clock::now();
+    table.Increment(keys[(size_t)std::rand() % keys.size()]);
+    change += NsPer(start, 1);
+  }
+
+  std::cout << std::setprecision(1) << std::fixed
+            << "  " << name << " copy (ns)   copy " << copy
+            << "  change after copy " << change / (copies == 0 ? 1 : copies)
+            << "   (" << sum << ")\n";
+}
+
+template < class K >
+void BenchThreads (const std::vector<K>& keys, size_t threads)
+// concurrent ingestion: one locked OAA against a ShardedOAA
+{
+  fsu::OAA<K,size_t> one;
+  std::mutex lock;
+  std::vector<std::thread> pool;
+  Clock::time_point start = Clock::now();
+  for (size_t t = 0; t < threads; ++t)
+    pool.push_back(std::thread([&keys, &one, &lock, t, threads]()
+    {
+      for (size_t i = t; i < keys.size(); i += threads)
+      {
+        std::lock_guard<std::mutex> hold(lock);
+        one.Increment(keys[i]);
+      }
+    }));
+  for (size_t t = 0; t < threads; ++t)
+    pool[t].join();
+  double locked = NsPer(start, keys.size());
+
+  fsu::ShardedOAA<K,size_t> sharded;
+  pool.clear();
+  start = Clock::now();
+  for (size_t t = 0; t < threads; ++t)
+    pool.push_back(std::thread([&keys, &sharded, t, threads]()
+    {
+      for (size_t i = t; i < keys.size(); i += threads)
+        sharded.Increment(keys[i]);
+    }));
+  for (size_t t = 0; t < threads; ++t)
+    pool[t].join();
+  double shards = NsPer(start, keys.size());
+
+  std::cout << std::setprecision(1) << std::fixed
+            << "  " << threads << " threads (ns/key)   locked OAA " << locked
+            << "  ShardedOAA " << shards
+            << "   (" << one.Size() << ' ' << sharded.Size() << ")\n";
+}
+
+void BenchCount (const std::vector<fsu::String>& keys, size_t threads)
+// concurrent word counting: one locked OAA against a HashCounter
+{
+  typedef fsu::OAA<fsu::InlineString,size_t,fsu::ThreeWay<fsu::InlineString> > Table;
+  Table one;
+  std::mutex lock;
+  std::vector<std::thread> pool;
+  Clock::time_point start = Clock::now();
+  for (size_t t = 0; t < threads; ++t)
+    pool.push_back(std::thread([&keys, &one, &lock, t, threads]()
+    {
+      for (size_t i = t; i < keys.size(); i += threads)
+      {
+        std::lock_guard<std::mutex> hold(lock);
+        one.Increment(fsu::StringView(keys[i]));
+      }
+    }));
+  for (size_t t = 0; t < threads; ++t)
+    pool[t].join();
+  double locked = NsPer(start, keys.size());
+
+  fsu::HashCounter counter;
+  pool.clear();
+  start = Clock::now();
+  for (size_t t = 0; t < threads; ++t)
+    pool.push_back(std::thread([&keys, &counter, t, threads]()
+    {
+      for (size_t i = t; i < keys.size(); i += threads)
+        counter.Increment(fsu::StringView(keys[i]));
+    }));
+  for (size_t t = 0; t < threads; ++t)
+    pool[t].join();
+  double hashed = NsPer(start, keys.size());
+
+  Table sorted;
+  start = Clock::now();
+  counter.LoadInto(sorted);
+  double load = NsPer(start, keys.size());
+
+  std::cout << std::setprecision(1) << std::fixed
+            << "  " << threads << " threads count (ns/word)   locked OAA " << locked
+            << "  HashCounter " << hashed << " + LoadInto " << load
+            << "   (" << one.Size() << ' ' << sorted.Size() << ")\n";
+}
+
+template < class K >
+void Shuffle (std::vector<K>& v)
+{
+  for (size_t i = v.size(); i > 1; --i)
+    std::swap(v[i-1], v[(size_t)std::rand() % i]);
+}
+
+void Header ()
+{
+  std::cout << "  " << std::setw(12) << std::left << "table" << std::right
+            << std::setw(9) << "keys"
+            << std::setw(12) << "bytes/node"
+            << std::setw(10) << "insert"
+            << std::setw(10) << "find"
+            << std::setw(10) << "rehashed" << "   (ns/op)\n";
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    std::cout << " ** program requires 1 or 2 arguments\n"
+              << "    1 = number of random int keys, or the name of a text file\n"
+              << "    2 = lookup rounds (default 5)\n"
+              << " ** try again\n";
+    return 0;
+  }
+  size_t rounds = (argc > 2) ? std::atoi(argv[2]) : 5;
+  std::srand(4530);
+
+  if (std::isdigit((unsigned char)argv[1][0]))
+  {
+    size_t n = std::atoi(argv[1]);
+    std::vector<int> keys(n);
+    for (size_t i = 0; i < n; ++i)
+      keys[i] = std::rand();
+    std::vector<int> probes(keys);
+    Shuffle(probes);
+    std::cout << "random int keys: " << n << '\n';
+    Header();
+    Bench< fsu::OAA<int,size_t> >       ("OAA",        keys, probes, rounds);
+    Bench< fsu::CompactOAA<int,size_t> >("CompactOAA", keys, probes, rounds);
+    BenchFrozen< fsu::OAA<int,size_t> > ("FrozenOAA",  keys, probes, rounds);
+    BenchBatch< fsu::OAA<int,size_t> >  (keys, probes, rounds);
+    for (size_t m = n / 1000; m <= n; m *= 10)
+      if (m > 0) BenchSorted< fsu::OAA<int,size_t> >(keys, m);
+    BenchMerge< fsu::OAA<int,size_t> >(keys, 8);
+    BenchCopy< fsu::OAA<int,size_t> >          ("OAA",           keys, 10);
+    BenchCopy< fsu::PersistentOAA<int,size_t> >("PersistentOAA", keys, 10);
+    BenchThreads(keys, 4);
+  }
+  else
+  {
+    std::ifstream in(argv[1]);
+    if (in.fail())
+    {
+      std::cout << " ** Error: cannot open file " << argv[1] << '\n';
+      return 0;
+    }
+    std::vector<fsu::String> keys;
+    fsu::String word;
+    while (in >> word)
+      keys.push_back(word);
+    std::vector<fsu::String> probes(keys);
+    Shuffle(probes);
+    std::cout << "words of " << argv[1] << ": " << keys.size() << '\n';
+    Header();
+    Bench< fsu::OAA<fsu::String,size_t> >       ("OAA",        keys, probes, rounds);
+    Bench< fsu::CompactOAA<fsu::String,size_t> >("CompactOAA", keys, probes, rounds);
+    BenchFrozen< fsu::OAA<fsu::String,size_t> > ("FrozenOAA",  keys, probes, rounds);
+    BenchCount(keys, 4);
+
+    typedef fsu::InlineString IS;
+    typedef fsu::ThreeWay<IS> P;
+    std::vector<IS> ikeys(keys.begin(), keys.end()), iprobes(probes.begin(), probes.end());
+    std::cout << "as InlineString keys:\n";
+    Bench< fsu::OAA<IS,size_t,P> >              ("OAA",        ikeys, iprobes, rounds);
+    Bench< fsu::CompactOAA<IS,size_t,P> >       ("CompactOAA", ikeys, iprobes, rounds);
+    BenchFrozen< fsu::OAA<IS,size_t,P> >        ("FrozenOAA",  ikeys, iprobes, rounds);
+    BenchBatch< fsu::OAA<IS,size_t,P> >         (ikeys, iprobes, rounds);
+  }
+  return 0;
+}
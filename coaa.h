@@ -0,0 +1,778 @@
+/*
+    coaa.h
+    10/16/26
+
+    CompactOAA: the left-leaning red-black table of oaa.h with its nodes kept
+    in one contiguous array.
+
+    Layout
+    ------
+    OAA allocates every node on its own and links them with 64-bit pointers,
+    plus a flags byte that the compiler pads out to a full word. CompactOAA
+    stores its nodes in a std::vector in allocation order and links them by
+    32-bit index. The two flag bits ride in the top bits of the index words:
+
+      lchild_  bit 31 = RED,  bits 0..30 = index of the left child
+      rchild_  bit 31 = DEAD, bits 0..30 = index of the right child
+
+    so a node is the key, the data and 8 bytes, against 17 bytes (24 with
+    padding) of links and flags in an OAA node. Nodes are next to each other
+    instead of scattered over the heap, so the top levels of the tree
+    share cache lines, and Rehash() lays the survivors out in key order.
+    There is room for 2^31 - 1 nodes (index 2^31 - 1 is the null link).
+
+    Interface
+    ---------
+    The table API is the one of OAA: Get, operator[], Put, Emplace, Upsert,
+    Increment, Find, Contains, Retrieve, Erase (a tombstone, compacted by the
+    same DeadRatio policy), Clear, Rehash, Reserve, the iterators and bounds,
+    Display, and the heterogeneous and three-way predicate support.
+    Augmentation (OrderStats), allocator policies and the Dump family belong
+    to OAA only.
+
+    Appending a node may move the whole array, so (as with OAA) any Get of a
+    new key invalidates iterators - and here also references returned by Get
+    and pointers returned by Find.
+*/
+
+#ifndef _COAA_H
+#define _COAA_H
+
+#include <cstddef>    // size_t
+#include <cstdint>    // uint32_t
+#include <cstdlib>    // abort
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <oaa.h>      // LessThan, DeadRatio, IsTransparent, IsThreeWay
+
+namespace fsu
+{
+
+  template < typename K , typename D , class P = LessThan<K> >
+  class CompactOAA
+  {
+  public:
+    typedef K         KeyType;
+    typedef D         DataType;
+    typedef P         PredicateType;
+    typedef uint32_t  Index;
+
+             CompactOAA  ();
+    explicit CompactOAA  (P p);
+             CompactOAA  (const CompactOAA& a) = default;
+             CompactOAA  (CompactOAA&& a);
+    CompactOAA& operator=(const CompactOAA& a) = default;
+    CompactOAA& operator=(CompactOAA&& a);
+    void Swap            (CompactOAA& a);
+
+    DataType& operator [] (const KeyType& k)        { return Get(k); }
+    DataType& operator [] (KeyType&& k)             { return Get(std::move(k)); }
+
+    void Put (const KeyType& k , const DataType& d) { PutKey(k, d); }
+    void Put (KeyType&& k , DataType&& d)           { PutKey(std::move(k), std::move(d)); }
+    D&   Get (const KeyType& k)                     { return GetKey(k); }
+    D&   Get (KeyType&& k)                          { return GetKey(std::move(k)); }
+
+    template < class... Args >
+    bool Emplace (const KeyType& k, Args&&... args) { return EmplaceKey(k, std::forward<Args>(args)...); }
+    template < class... Args >
+    bool Emplace (KeyType&& k, Args&&... args)      { return EmplaceKey(std::move(k), std::forward<Args>(args)...); }
+
+    template <class F>  //F is applied to the data of k
+    const D& Upsert    (const KeyType& k, F f) { return UpsertKey(k, f); }
+    template <class F>
+    const D& Upsert    (KeyType&& k, F f)      { return UpsertKey(std::move(k), f); }
+    const D& Increment (const KeyType& k, const DataType& delta = DataType(1))
+    {
+      return UpsertKey(k, [&delta](DataType& d) { d += delta; });
+    }
+    const D& Increment (KeyType&& k, const DataType& delta = DataType(1))
+    {
+      return UpsertKey(std::move(k), [&delta](DataType& d) { d += delta; });
+    }
+
+    const D* Find     (const KeyType& k) const { return FindData(k); }
+    bool     Contains (const KeyType& k) const { return FindNode(k) != NIL; }
+    bool     Retrieve (const KeyType& k, DataType& d) const { return RetrieveKey(k, d); }
+
+    // heterogeneous lookup, as in OAA
+    template < class KK >
+    using IfTransparent = typename std::enable_if<IsTransparent<P>::value, KK>::type;
+
+    template < class KK , class = IfTransparent<KK> >
+    DataType& operator [] (const KK& k)         { return GetKey(k); }
+    template < class KK , class = IfTransparent<KK> >
+    D&       Get       (const KK& k)            { return GetKey(k); }
+    template < class KK , class F , class = IfTransparent<KK> >
+    const D& Upsert    (const KK& k, F f)       { return UpsertKey(k, f); }
+    template < class KK , class = IfTransparent<KK> >
+    const D& Increment (const KK& k, const DataType& delta = DataType(1))
+    {
+      return UpsertKey(k, [&delta](DataType& d) { d += delta; });
+    }
+    template < class KK , class = IfTransparent<KK> >
+    const D* Find      (const KK& k) const      { return FindData(k); }
+    template < class KK , class = IfTransparent<KK> >
+    bool     Contains  (const KK& k) const      { return FindNode(k) != NIL; }
+    template < class KK , class = IfTransparent<KK> >
+    bool     Retrieve  (const KK& k, DataType& d) const { return RetrieveKey(k, d); }
+
+    void Erase   (const KeyType& k);
+    void Clear   ();
+    void Rehash  ();
+    void Reserve (size_t n) { nodes_.reserve(n); } // room for n nodes in total
+
+    void             SetRehashPolicy (const DeadRatio& r) { rehash_ = r; }
+    const DeadRatio& RehashPolicy    () const             { return rehash_; }
+
+    size_t BytesInUse    () const { return nodes_.size() * sizeof(Node); }
+    size_t BytesReserved () const { return nodes_.capacity() * sizeof(Node); }
+
+    bool   Empty    () const { return size_ == 0; }
+    size_t Size     () const { return size_; }           // counts alive nodes
+    size_t NumNodes () const { return nodes_.size(); }   // counts nodes
+    int    Height   () const { return RHeight(root_); }
+
+    class Iterator;
+    class ConstIterator;
+
+    Iterator      Begin      ()       { return Iterator(Begin_()); }
+    Iterator      End        ()       { return Iterator(ConstIterator(this)); }
+    Iterator      rBegin     ()       { return Iterator(rBegin_()); }
+    Iterator      rEnd       ()       { return Iterator(ConstIterator(this)); }
+    Iterator      LowerBound (const KeyType& k) { return Iterator(Lower(k)); }
+    Iterator      UpperBound (const KeyType& k) { return Iterator(Upper(k)); }
+
+    ConstIterator Begin      () const { return Begin_(); }
+    ConstIterator End        () const { return ConstIterator(this); }
+    ConstIterator rBegin     () const { return rBegin_(); }
+    ConstIterator rEnd       () const { return ConstIterator(this); }
+    ConstIterator LowerBound (const KeyType& k) const { return Lower(k); }
+    ConstIterator UpperBound (const KeyType& k) const { return Upper(k); }
+
+    void   Display (std::ostream& os, int kw, int dw,     // key, data widths
+                    std::ios_base::fmtflags kf = std::ios_base::right, // key flag
+                    std::ios_base::fmtflags df = std::ios_base::right // data flag
+                   ) const;
+
+  private:
+    static const Index NIL  = 0x7FFFFFFF;  // null link, also the index mask
+    static const Index FLAG = 0x80000000;  // RED in lchild_, DEAD in rchild_
+
+    class Node
+    {
+    public:
+      template < class KK , class... Args >
+      explicit Node (KK&& k, Args&&... args)
+        : key_(std::forward<KK>(k)), data_(std::forward<Args>(args)...),
+          lchild_(FLAG | NIL), rchild_(NIL)       // red, alive, no children
+      {}
+
+      Index Left     () const { return lchild_ & NIL; }
+      Index Right    () const { return rchild_ & NIL; }
+      void  SetLeft  (Index i) { lchild_ = (lchild_ & FLAG) | i; }
+      void  SetRight (Index i) { rchild_ = (rchild_ & FLAG) | i; }
+
+      bool  IsRed    () const { return (lchild_ & FLAG) != 0; }
+      bool  IsBlack  () const { return !IsRed(); }
+      bool  IsDead   () const { return (rchild_ & FLAG) != 0; }
+      bool  IsAlive  () const { return !IsDead(); }
+      void  SetRed   ()       { lchild_ |= FLAG; }
+      void  SetBlack ()       { lchild_ &= NIL; }
+      void  SetDead  ()       { rchild_ |= FLAG; }
+      void  SetAlive ()       { rchild_ &= NIL; }
+
+      KeyType   key_;     // never changed while the node is in a tree
+      DataType  data_;
+      Index     lchild_;
+      Index     rchild_;
+    }; // class Node
+
+  public: // iterators
+
+    class ConstIterator
+    {
+    public:
+      ConstIterator () : path_(), tree_(nullptr) {}
+
+      const KeyType&  Key   () const { return tree_->nodes_[path_.back()].key_; }
+      const DataType& Data  () const { return tree_->nodes_[path_.back()].data_; }
+      bool            Valid () const { return !path_.empty(); }
+
+      ConstIterator& operator ++ ()    { Next(); return *this; }
+      ConstIterator  operator ++ (int) { ConstIterator i(*this); Next(); return i; }
+      ConstIterator& operator -- ()    { Prev(); return *this; }
+      ConstIterator  operator -- (int) { ConstIterator i(*this); Prev(); return i; }
+
+      bool operator == (const ConstIterator& i) const { return Current() == i.Current(); }
+      bool operator != (const ConstIterator& i) const { return Current() != i.Current(); }
+
+    protected:
+      friend class CompactOAA<K,D,P>;
+      explicit ConstIterator (const CompactOAA * tree) : path_(), tree_(tree) {}
+
+      const Node& At (Index i) const { return tree_->nodes_[i]; }
+      Index Current  () const { return path_.empty() ? NIL : path_.back(); }
+      void  Next     (); // to the next alive node
+      void  Prev     (); // to the previous alive node
+      void  Step     (); // to the next node, dead or alive
+      void  StepBack (); // to the previous node, dead or alive
+      void  Lowest   (Index n);  // push the left spine of n
+      void  Highest  (Index n);  // push the right spine of n
+
+      std::vector<Index>  path_;  // root .. current node; empty at End
+      const CompactOAA *  tree_;
+    }; // class ConstIterator
+
+    class Iterator : public ConstIterator
+    {
+    public:
+      Iterator () : ConstIterator() {}
+
+      DataType& Data () const
+      {
+        return const_cast<CompactOAA*>(this->tree_)->nodes_[this->path_.back()].data_;
+      }
+
+      Iterator& operator ++ ()    { this->Next(); return *this; }
+      Iterator  operator ++ (int) { Iterator i(*this); this->Next(); return i; }
+      Iterator& operator -- ()    { this->Prev(); return *this; }
+      Iterator  operator -- (int) { Iterator i(*this); this->Prev(); return i; }
+
+    private:
+      friend class CompactOAA<K,D,P>;
+      explicit Iterator (const ConstIterator& i) : ConstIterator(i) {}
+    }; // class Iterator
+
+  private: // data
+    std::vector<Node>  nodes_;    // in allocation order
+    Index              root_;
+    PredicateType      pred_;
+    size_t             size_;     // alive nodes
+    DeadRatio          rehash_;   // when Erase compacts the array
+
+  private: // methods
+    typedef std::integral_constant < bool , IsThreeWay<P,K>::value > ThreeWayPredicate;
+    template < class KK >
+    int Cmp (const KK& a, const K& b) const { return Cmp(a, b, ThreeWayPredicate()); }
+    template < class KK >
+    int Cmp (const KK& a, const K& b, std::true_type) const { return pred_.Compare(a,b); }
+    template < class KK >
+    int Cmp (const KK& a, const K& b, std::false_type) const
+    {
+      return pred_(a,b) ? -1 : (pred_(b,a) ? 1 : 0);
+    }
+
+    bool  IsRed       (Index i) const { return i != NIL && nodes_[i].IsRed(); }
+    Index RotateLeft  (Index n);
+    Index RotateRight (Index n);
+    int   RHeight     (Index n) const;
+
+    template < class KK , class... Args >
+    Index NewNode (KK&& k, Args&&... args);
+
+    // recursive left-leaning get, as OAA::RGet but on indices; nodes_ may
+    // grow inside the recursion, so no reference into it is held across a call
+    template < class KK , class... Args >
+    Index RGet (Index n, KK&& kval, Index& location, Args&&... args);
+
+    template < class KK >
+    Index Locate   (const KK& kval) const;
+    template < class KK >
+    Index FindNode (const KK& kval) const
+    {
+      Index n = Locate(kval);
+      return (n != NIL && nodes_[n].IsAlive()) ? n : NIL;
+    }
+    template < class KK >
+    const D* FindData (const KK& k) const
+    {
+      Index n = FindNode(k);
+      return (n == NIL) ? nullptr : &nodes_[n].data_;
+    }
+    template < class KK >
+    bool RetrieveKey (const KK& k, DataType& d) const
+    {
+      Index n = FindNode(k);
+      if (n == NIL) return false;
+      d = nodes_[n].data_;
+      return true;
+    }
+
+    template < class KK >
+    D&       GetKey     (KK&& k);
+    template < class KK , class DD >
+    void     PutKey     (KK&& k, DD&& d);
+    template < class KK , class... Args >
+    bool     EmplaceKey (KK&& k, Args&&... args);
+    template < class KK , class F >
+    const D& UpsertKey  (KK&& k, F f);
+
+    ConstIterator Begin_ () const { ConstIterator i(this); i.Next(); return i; }
+    ConstIterator rBegin_() const { ConstIterator i(this); i.Prev(); return i; }
+    ConstIterator Lower  (const K& kval) const; // first alive key >= k
+    ConstIterator Upper  (const K& kval) const; // first alive key > k
+
+    // Rehash: RCollect lists the alive nodes in key order, RBuild links
+    // nodes first .. first+n-1 of the new array into a minimum height LLRB
+    void   RCollect  (Index n, std::vector<Index>& order) const;
+    Index  RBuild    (std::vector<Node>& nodes, Index first, size_t n, int h) const;
+  }; // class CompactOAA<>
+
+  template < typename K , typename D , class P >
+  const typename CompactOAA<K,D,P>::Index CompactOAA<K,D,P>::NIL;
+
+  template < typename K , typename D , class P >
+  const typename CompactOAA<K,D,P>::Index CompactOAA<K,D,P>::FLAG;
+
+  // constructors and assignment
+
+  template < typename K , typename D , class P >
+  CompactOAA<K,D,P>::CompactOAA () : nodes_(), root_(NIL), pred_(), size_(0)
+  {}
+
+  template < typename K , typename D , class P >
+  CompactOAA<K,D,P>::CompactOAA (P p) : nodes_(), root_(NIL), pred_(p), size_(0)
+  {}
+
+  template < typename K , typename D , class P >
+  CompactOAA<K,D,P>::CompactOAA (CompactOAA&& a)
+    : nodes_(), root_(NIL), pred_(a.pred_), size_(0), rehash_(a.rehash_)
+  {
+    Swap(a);
+  }
+
+  template < typename K , typename D , class P >
+  CompactOAA<K,D,P>& CompactOAA<K,D,P>::operator= (CompactOAA&& a)
+  {
+    if (this != &a)
+    {
+      Clear();
+      Swap(a);
+    }
+    return *this;
+  }
+
+  template < typename K , typename D , class P >
+  void CompactOAA<K,D,P>::Swap (CompactOAA& a)
+  {
+    nodes_.swap(a.nodes_);
+    std::swap(root_, a.root_);
+    std::swap(pred_, a.pred_);
+    std::swap(size_, a.size_);
+    std::swap(rehash_, a.rehash_);
+  }
+
+  // table operations
+
+  template < typename K , typename D , class P >
+  template < class KK >
+  D& CompactOAA<K,D,P>::GetKey (KK&& k)
+  {
+    Index location;
+    root_ = RGet(root_, std::forward<KK>(k), location);
+    nodes_[root_].SetBlack();
+    return nodes_[location].data_;
+  }
+
+  template < typename K , typename D , class P >
+  template < class KK , class F >
+  const D& CompactOAA<K,D,P>::UpsertKey (KK&& k, F f)
+  // a hit on an alive key is a plain descent with no rebalancing
+  {
+    Index n = Locate(k);
+    if (n == NIL)
+    {
+      root_ = RGet(root_, std::forward<KK>(k), n);
+      nodes_[root_].SetBlack();
+    }
+    else if (nodes_[n].IsDead())
+    {
+      nodes_[n].SetAlive();
+      ++size_;
+    }
+    f(nodes_[n].data_);
+    return nodes_[n].data_;
+  }
+
+  template < typename K , typename D , class P >
+  template < class KK , class DD >
+  void CompactOAA<K,D,P>::PutKey (KK&& k, DD&& d)
+  {
+    Index n = Locate(k);
+    if (n == NIL)
+    {
+      root_ = RGet(root_, std::forward<KK>(k), n, std::forward<DD>(d));
+      nodes_[root_].SetBlack();
+      return;
+    }
+    if (nodes_[n].IsDead())
+    {
+      nodes_[n].SetAlive();
+      ++size_;
+    }
+    nodes_[n].data_ = std::forward<DD>(d);
+  }
+
+  template < typename K , typename D , class P >
+  template < class KK , class... Args >
+  bool CompactOAA<K,D,P>::EmplaceKey (KK&& k, Args&&... args)
+  {
+    Index n = Locate(k);
+    if (n == NIL)
+    {
+      root_ = RGet(root_, std::forward<KK>(k), n, std::forward<Args>(args)...);
+      nodes_[root_].SetBlack();
+      return true;
+    }
+    if (nodes_[n].IsAlive())
+      return false;
+    nodes_[n].SetAlive();
+    ++size_;
+    nodes_[n].data_ = D(std::forward<Args>(args)...);
+    return true;
+  }
+
+  template < typename K , typename D , class P >
+  void CompactOAA<K,D,P>::Erase (const KeyType& k)
+  // marks the node of k dead; the array is compacted once rehash_ says so
+  {
+    Index n = FindNode(k);
+    if (n == NIL) return;
+    nodes_[n].SetDead();
+    nodes_[n].data_ = D();  // a revived key starts over with DataType()
+    --size_;
+    if (rehash_(nodes_.size(), nodes_.size() - size_))
+      Rehash();
+  }
+
+  template < typename K , typename D , class P >
+  void CompactOAA<K,D,P>::Clear ()
+  {
+    std::vector<Node>().swap(nodes_);  // gives the storage back
+    root_ = NIL;
+    size_ = 0;
+  }
+
+  template < typename K , typename D , class P >
+  void CompactOAA<K,D,P>::Rehash ()
+  /*
+    Moves the alive nodes, in key order, into a new array of exactly size_
+    nodes and links them as a minimum height LLRB. Dead nodes are dropped;
+    no key is compared. A subtree then occupies a contiguous block of the
+    array, which keeps the tail of each descent within a few cache lines.
+  */
+  {
+    std::vector<Index> order;
+    order.reserve(size_);
+    RCollect(root_, order);
+    std::vector<Node> nodes;
+    nodes.reserve(order.size());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+      nodes.push_back(std::move(nodes_[order[i]]));
+      nodes.back().lchild_ = NIL;   // black, no children
+      nodes.back().rchild_ = NIL;   // alive
+    }
+    size_t n = nodes.size();
+    int h = 0;                      // largest h with 2^h - 1 <= n
+    while (h < 31 && (((size_t)1 << (h+1)) - 1) <= n)
+      ++h;
+    root_ = RBuild(nodes, 0, n, h);
+    nodes_.swap(nodes);
+  }
+
+  template < typename K , typename D , class P >
+  void CompactOAA<K,D,P>::Display (std::ostream& os, int kw, int dw, std::ios_base::fmtflags kf, std::ios_base::fmtflags df) const
+  // Displays tree as inorder traversal
+  {
+    for (ConstIterator i = Begin(); i != End(); ++i)
+    {
+      os.setf(kf,std::ios_base::adjustfield);
+      os << std::setw(kw) << i.Key();
+      os.setf(df,std::ios_base::adjustfield);
+      os << std::setw(dw) << i.Data();
+      os << '\n';
+    }
+  }
+
+  // private methods
+
+  template < typename K , typename D , class P >
+  template < class KK , class... Args >
+  typename CompactOAA<K,D,P>::Index CompactOAA<K,D,P>::NewNode (KK&& k, Args&&... args)
+  {
+    if (nodes_.size() >= NIL)
+    {
+      std::cerr << "** CompactOAA: more than 2^31 - 1 nodes\n";
+      std::abort();
+    }
+    nodes_.emplace_back(std::forward<KK>(k), std::forward<Args>(args)...);
+    return (Index)(nodes_.size() - 1);
+  }
+
+  template < typename K , typename D , class P >
+  template < class KK >
+  typename CompactOAA<K,D,P>::Index CompactOAA<K,D,P>::Locate (const KK& kval) const
+  {
+    Index n = root_;
+    while (n != NIL)
+    {
+      const Node& x = nodes_[n];
+      int c = Cmp(kval,x.key_);
+      if (c < 0)
+        n = x.Left();
+      else if (c > 0)
+        n = x.Right();
+      else
+        return n;
+    }
+    return NIL;
+  }
+
+  template < typename K , typename D , class P >
+  template < class KK , class... Args >
+  typename CompactOAA<K,D,P>::Index CompactOAA<K,D,P>::RGet (Index n, KK&& kval, Index& location, Args&&... args)
+  {
+    if (n == NIL)    // add new node at bottom of tree
+    {
+      location = NewNode(std::forward<KK>(kval), std::forward<Args>(args)...); // alive and red
+      ++size_;
+      return location;
+    }
+
+    int c = Cmp(kval,nodes_[n].key_);
+    if (c < 0)
+    {
+      Index l = RGet(nodes_[n].Left(), std::forward<KK>(kval), location, std::forward<Args>(args)...);
+      nodes_[n].SetLeft(l);
+    }
+    else if (c > 0)
+    {
+      Index r = RGet(nodes_[n].Right(), std::forward<KK>(kval), location, std::forward<Args>(args)...);
+      nodes_[n].SetRight(r);
+    }
+    else
+    {
+      if (nodes_[n].IsDead())
+      {
+        nodes_[n].SetAlive();  // revives a dead node
+        ++size_;
+      }
+      location = n;
+    }
+
+    // repair on the way back up tree
+    if (IsRed(nodes_[n].Right()) && !IsRed(nodes_[n].Left()))
+      n = RotateLeft(n);
+    if (IsRed(nodes_[n].Left()) && IsRed(nodes_[nodes_[n].Left()].Left()))
+      n = RotateRight(n);
+    if (IsRed(nodes_[n].Left()) && IsRed(nodes_[n].Right()))
+    {
+      nodes_[nodes_[n].Left()].SetBlack();
+      nodes_[nodes_[n].Right()].SetBlack();
+      nodes_[n].SetRed();
+    }
+    return n;
+  }
+
+  template < typename K , typename D , class P >
+  typename CompactOAA<K,D,P>::Index CompactOAA<K,D,P>::RotateLeft (Index n)
+  {
+    Node& x = nodes_[n];
+    Index p = x.Right();
+    Node& y = nodes_[p];
+    x.SetRight(y.Left());
+    y.SetLeft(n);
+    x.IsRed() ? y.SetRed() : y.SetBlack();
+    x.SetRed();
+    return p;
+  }
+
+  template < typename K , typename D , class P >
+  typename CompactOAA<K,D,P>::Index CompactOAA<K,D,P>::RotateRight (Index n)
+  {
+    Node& x = nodes_[n];
+    Index p = x.Left();
+    Node& y = nodes_[p];
+    x.SetLeft(y.Right());
+    y.SetRight(n);
+    x.IsRed() ? y.SetRed() : y.SetBlack();
+    x.SetRed();
+    return p;
+  }
+
+  template < typename K , typename D , class P >
+  int CompactOAA<K,D,P>::RHeight (Index n) const
+  {
+    if (n == NIL) return -1;
+    int l = RHeight(nodes_[n].Left()), r = RHeight(nodes_[n].Right());
+    return 1 + (l > r ? l : r);
+  }
+
+  template < typename K , typename D , class P >
+  void CompactOAA<K,D,P>::RCollect (Index n, std::vector<Index>& order) const
+  {
+    if (n == NIL) return;
+    RCollect(nodes_[n].Left(), order);
+    if (nodes_[n].IsAlive())
+      order.push_back(n);
+    RCollect(nodes_[n].Right(), order);
+  }
+
+  template < typename K , typename D , class P >
+  typename CompactOAA<K,D,P>::Index CompactOAA<K,D,P>::RBuild (std::vector<Node>& nodes, Index first, size_t n, int h) const
+  // the same shape as OAA::RBuild (see there); pre: 2^h - 1 <= n <= 2^(h+1) - 2
+  {
+    if (n == 0) return NIL;
+    size_t full = ((size_t)1 << h) - 1;
+    Index root;
+    if (n == 2 * full)
+    {
+      size_t half = full / 2;
+      Index red = first + (Index)half;
+      nodes[red].SetLeft(RBuild(nodes, first, half, h-1));
+      nodes[red].SetRight(RBuild(nodes, red + 1, half, h-1));
+      nodes[red].SetRed();
+      root = red + (Index)half + 1;
+      nodes[root].SetLeft(red);
+      nodes[root].SetRight(RBuild(nodes, root + 1, n - full - 1, h-1));
+    }
+    else
+    {
+      size_t nl = n / 2;
+      root = first + (Index)nl;
+      nodes[root].SetLeft(RBuild(nodes, first, nl, h-1));
+      nodes[root].SetRight(RBuild(nodes, root + 1, n - 1 - nl, h-1));
+    }
+    nodes[root].SetBlack();
+    return root;
+  }
+
+  template < typename K , typename D , class P >
+  typename CompactOAA<K,D,P>::ConstIterator CompactOAA<K,D,P>::Lower (const K& kval) const
+  // the search path down to the last node where the search turns left
+  {
+    ConstIterator i(this);
+    size_t keep = 0;
+    for (Index n = root_; n != NIL; )
+    {
+      i.path_.push_back(n);
+      if (pred_(nodes_[n].key_,kval))
+      {
+        n = nodes_[n].Right();
+      }
+      else
+      {
+        keep = i.path_.size();
+        n = nodes_[n].Left();
+      }
+    }
+    i.path_.resize(keep);
+    if (i.Valid() && nodes_[i.Current()].IsDead())
+      i.Next();
+    return i;
+  }
+
+  template < typename K , typename D , class P >
+  typename CompactOAA<K,D,P>::ConstIterator CompactOAA<K,D,P>::Upper (const K& kval) const
+  {
+    ConstIterator i(this);
+    size_t keep = 0;
+    for (Index n = root_; n != NIL; )
+    {
+      i.path_.push_back(n);
+      if (pred_(kval,nodes_[n].key_))
+      {
+        keep = i.path_.size();
+        n = nodes_[n].Left();
+      }
+      else
+      {
+        n = nodes_[n].Right();
+      }
+    }
+    i.path_.resize(keep);
+    if (i.Valid() && nodes_[i.Current()].IsDead())
+      i.Next();
+    return i;
+  }
+
+  // iterator stepping, as in OAA
+
+  template < typename K , typename D , class P >
+  void CompactOAA<K,D,P>::ConstIterator::Next ()
+  {
+    if (path_.empty())
+      Lowest(tree_->root_);
+    else
+      Step();
+    while (!path_.empty() && At(path_.back()).IsDead())
+      Step();
+  }
+
+  template < typename K , typename D , class P >
+  void CompactOAA<K,D,P>::ConstIterator::Prev ()
+  {
+    if (path_.empty())
+      Highest(tree_->root_);
+    else
+      StepBack();
+    while (!path_.empty() && At(path_.back()).IsDead())
+      StepBack();
+  }
+
+  template < typename K , typename D , class P >
+  void CompactOAA<K,D,P>::ConstIterator::Step ()
+  {
+    Index n = path_.back();
+    if (At(n).Right() != NIL)
+    {
+      Lowest(At(n).Right());
+      return;
+    }
+    do
+    {
+      n = path_.back();
+      path_.pop_back();
+    }
+    while (!path_.empty() && At(path_.back()).Right() == n);
+  }
+
+  template < typename K , typename D , class P >
+  void CompactOAA<K,D,P>::ConstIterator::StepBack ()
+  {
+    Index n = path_.back();
+    if (At(n).Left() != NIL)
+    {
+      Highest(At(n).Left());
+      return;
+    }
+    do
+    {
+      n = path_.back();
+      path_.pop_back();
+    }
+    while (!path_.empty() && At(path_.back()).Left() == n);
+  }
+
+  template < typename K , typename D , class P >
+  void CompactOAA<K,D,P>::ConstIterator::Lowest (Index n)
+  {
+    for (; n != NIL; n = At(n).Left())
+      path_.push_back(n);
+  }
+
+  template < typename K , typename D , class P >
+  void CompactOAA<K,D,P>::ConstIterator::Highest (Index n)
+  {
+    for (; n != NIL; n = At(n).Right())
+      path_.push_back(n);
+  }
+
+} // namespace fsu
+
+#endif
@@ -0,0 +1,44 @@
+/*
+    compare3.h
+    10/16/26
+
+    ThreeWay<T>: a predicate class that is a drop-in for LessThan<T> and also
+    answers the three-way question
+
+      Compare(a,b)  negative if a < b, zero if a == b, positive if a > b
+
+    OAA uses Compare when its predicate has one, so each step of a descent
+    costs one comparison where a less-than-only predicate needs up to two
+    (a < key, then key < a). Predicates without Compare keep working exactly
+    as before.
+
+    The general template still answers with operator<, so it gains only for
+    types whose operator< is cheap. ThreeWay<fsu::String> compares the
+    characters once, memcmp style, and is transparent like StringLess (see
+    strview.h), so it also accepts StringView and const char* keys.
+*/
+
+#ifndef _COMPARE3_H
+#define _COMPARE3_H
+
+#include <xstring.h>
+#include <strview.h>
+
+namespace fsu
+{
+
+  template < typename T >
+  class ThreeWay
+  {
+  public:
+    bool operator () (const T& a, const T& b) const { return a < b; }
+    int  Compare     (const T& a, const T& b) const { return (a < b) ? -1 : (b < a); }
+  };
+
+  template < >
+  class ThreeWay < String > : public StringLess
+  {};
+
+} // namespace fsu
+
+#endif
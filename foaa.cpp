@@ -11,6 +11,8 @@
 #include <fstream>
 #include <iomanip>
 #include <cmath>
+#include <vector>
+#include <utility>
 
 // <String, int>
 #include <xstring.h>
@@ -205,7 +207,23 @@ int main(int argc, char* argv[])
                 << " = aa.Get(" << key << ")\n";
       dw1 = CorrectDataWidth(key,dw1);
       break;
-      /*   case 'e': case 'E':
+    case 'f': case 'F':
+      *inptr >> key;
+      if (inptr->fail())
+      {
+        std::cout << " ** bad key encountered - re-enter command\n";
+        inptr->clear();
+        while (command != '\n') command = inptr->get();
+        inptr->clear();
+        break;
+      }
+      if (BATCH) std::cout << ' ' << key << '\n';
+      if (aa.Retrieve(key,data))
+        std::cout << "  aa.Retrieve(" << key << ",d) : d = " << data << '\n';
+      else
+        std::cout << "  aa.Contains(" << key << ") = " << aa.Contains(key) << '\n';
+      break;
+    case 'e': case 'E':
       *inptr >> key;
       if (inptr->fail())
       {
@@ -218,7 +236,7 @@ int main(int argc, char* argv[])
       if (BATCH) std::cout << ' ' << key << '\n';
       std::cout << "  aa.Erase(" << key << ")\n";
       aa.Erase(key);
-      break;*/
+      break;
     case 'd': case 'D':
       *inptr >> command;
       if (BATCH) std::cout << command << '\n';
@@ -301,6 +319,54 @@ int main(int argc, char* argv[])
       ifs.close();
       std::cout << "  ** table data read and stored\n";
       break;
+    case 'r': case 'R':
+      {
+        KeyType hi;
+        *inptr >> key >> hi;
+        if (inptr->fail())
+        {
+          std::cout << " ** bad key encountered - re-enter command\n";
+          if (inptr->eof())   // nothing left to re-enter it from
+          {
+            command = 'q';
+            break;
+          }
+          inptr->clear();
+          while (command != '\n') command = inptr->get();
+          inptr->clear();
+          break;
+        }
+        if (BATCH) std::cout << ' ' << key << ' ' << hi << '\n';
+        std::cout << "  keys in [" << key << ',' << hi << "):";
+        for (fsu::OAA<KeyType,DataType>::ConstIterator i = aa.LowerBound(key); i.Valid() && i.Key() < hi; ++i)
+          std::cout << ' ' << i.Key() << ':' << i.Data();
+        std::cout << '\n';
+      }
+      break;
+    case 'b': case 'B':
+      *inptr >> key;
+      if (BATCH) std::cout << ' ' << key << '\n';
+      ifs.open(key.Cstr());
+      if (ifs.fail())
+      {
+        std::cout << "  ** Unable to open file " << key << '\n';
+        ifs.clear();
+        break;
+      }
+      {
+        std::vector < std::pair < KeyType, DataType > > pairs;
+        while (ifs >> key >> data)
+        {
+          pairs.push_back(std::make_pair(key,data));
+          dw1 = CorrectDataWidth(key,dw1);
+          dw2 = CorrectDataWidth(data,dw2);
+        }
+        aa.BulkLoad(pairs.begin(), pairs.end());
+      }
+      ifs.clear();
+      ifs.close();
+      std::cout << "  ** table data bulk loaded\n";
+      break;
     case 'H': case 'h':
       if (BATCH) std::cout << '\n';
       aa.Rehash();
@@ -332,8 +398,10 @@ void DisplayMenu(std::ostream& os)
   os << "   OPERATION                       ENTRY\n"
      << "   ---------                       -----\n"
      << "   Load data from file  .......... L filename\n"
+     << "   Bulk load from file  .......... B filename\n"
      << "   x.Put(key,data)  .............. 1 key data\n"
      << "   x.Get(key) .................... 2 key\n"
+     << "   x.Retrieve(key,d) ............. F key\n"
      << "   x.Erase(key) .................. E key\n"
      << "   aa[key] = data  ............... [ key ] = data\n"
      << "   data = aa[key]  ............... [ key ]\n"
@@ -344,6 +412,7 @@ void DisplayMenu(std::ostream& os)
      << "   x.Dump(cout,ofc,fill) ......... D3\n"
      << "   Size test  .................... S\n"
      << "   traversal  .................... T\n"
+     << "   range scan [lo,hi) ............ R lo hi\n"
      << "   Rehash  ....................... H\n"
      << "   Copy/Assign test .............. =\n"
      << "   switch from batch mode ........ X\n"
@@ -0,0 +1,317 @@
+/*
+    frozenoaa.h
+    10/16/26
+
+    FrozenOAA: an immutable, read-optimized snapshot of an OAA, made by
+    OAA::Freeze() (defined here, so include this header to call it).
+
+    Layout
+    ------
+    The alive keys are stored in breadth-first ("Eytzinger") order in one
+    array: the root at index 1, the children of i at 2i and 2i+1. The data
+    live in a parallel array, so a search touches keys only. A search is
+
+      i = 1;  while (i <= n) i = 2i + (key[i] < k);
+
+    with no early exit and a loop body the compiler can make branch free.
+    The descendants of i four levels down (for 4-byte keys; fewer for
+    wider ones) sit next to each other at 16i .. 16i+15, so one prefetch
+    per level (__builtin_prefetch, GNU compilers only) fetches them while
+    the current levels are compared. The top levels of every search share
+    the first few cache lines of the array.
+
+    When the loop ends, the bits of i record the turns taken; dropping the
+    trailing right turns and one more bit leaves the last node where the
+    search went left, which is the lower bound (0 if there is none).
+
+    There are no links, colors or dead nodes: a frozen entry costs
+    sizeof(K) + sizeof(D) bytes against sizeof(K) + sizeof(D) + 24 for an
+    OAA node.
+
+    Interface
+    ---------
+    Find, Contains, Retrieve (also heterogeneous with a transparent P),
+    LowerBound, UpperBound, Begin/End/rBegin/rEnd and in-order iteration in
+    both directions, Size, Empty, BytesInUse, Display. A FrozenOAA never
+    changes; build a new one from the live OAA to pick up later updates.
+*/
+
+#ifndef _FROZENOAA_H
+#define _FROZENOAA_H
+
+#include <cstddef>    // size_t
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <oaa.h>      // OAA, LessThan, IsTransparent
+
+namespace fsu
+{
+
+  // largest power of 2 not above x, 1 for x < 2
+  constexpr size_t Pow2Floor (size_t x) { return (x < 2) ? 1 : 2 * Pow2Floor(x / 2); }
+
+  template < typename K , typename D , class P = LessThan<K> >
+  class FrozenOAA
+  {
+  public:
+    typedef K  KeyType;
+    typedef D  DataType;
+    typedef P  PredicateType;
+
+    FrozenOAA () : keys_(1), data_(1), pred_(), n_(0) {}  // empty
+
+    class ConstIterator;
+
+    const D* Find     (const KeyType& k) const { return FindData(k); }
+    bool     Contains (const KeyType& k) const { return FindIndex(k) != 0; }
+    bool     Retrieve (const KeyType& k, DataType& d) const { return RetrieveKey(k, d); }
+
+    template < class KK >
+    using IfTransparent = typename std::enable_if<IsTransparent<P>::value, KK>::type;
+
+    template < class KK , class = IfTransparent<KK> >
+    const D* Find     (const KK& k) const { return FindData(k); }
+    template < class KK , class = IfTransparent<KK> >
+    bool     Contains (const KK& k) const { return FindIndex(k) != 0; }
+    template < class KK , class = IfTransparent<KK> >
+    bool     Retrieve (const KK& k, DataType& d) const { return RetrieveKey(k, d); }
+
+    ConstIterator Begin      () const { return ConstIterator(this, First()); }
+    ConstIterator End        () const { return ConstIterator(this, 0); }
+    ConstIterator rBegin     () const { return ConstIterator(this, Last()); }
+    ConstIterator rEnd       () const { return ConstIterator(this, 0); }
+    ConstIterator LowerBound (const KeyType& k) const { return ConstIterator(this, Lower(k)); }
+    ConstIterator UpperBound (const KeyType& k) const { return ConstIterator(this, Upper(k)); }
+
+    bool   Empty      () const { return n_ == 0; }
+    size_t Size       () const { return n_; }
+    size_t BytesInUse () const { return keys_.size() * sizeof(K) + data_.size() * sizeof(D); }
+
+    void   Display (std::ostream& os, int kw, int dw,     // key, data widths
+                    std::ios_base::fmtflags kf = std::ios_base::right, // key flag
+                    std::ios_base::fmtflags df = std::ios_base::right // data flag
+                   ) const;
+
+    class ConstIterator
+    {
+    public:
+      ConstIterator () : tree_(nullptr), i_(0) {}
+
+      const KeyType&  Key   () const { return tree_->keys_[i_]; }
+      const DataType& Data  () const { return tree_->data_[i_]; }
+      bool            Valid () const { return i_ != 0; }
+
+      ConstIterator& operator ++ ()    { i_ = tree_->Next(i_); return *this; }
+      ConstIterator  operator ++ (int) { ConstIterator i(*this); ++*this; return i; }
+      ConstIterator& operator -- ()    { i_ = tree_->Prev(i_); return *this; }
+      ConstIterator  operator -- (int) { ConstIterator i(*this); --*this; return i; }
+
+      bool operator == (const ConstIterator& i) const { return i_ == i.i_; }
+      bool operator != (const ConstIterator& i) const { return i_ != i.i_; }
+
+    private:
+      friend class FrozenOAA<K,D,P>;
+      ConstIterator (const FrozenOAA * tree, size_t i) : tree_(tree), i_(i) {}
+
+      const FrozenOAA * tree_;
+      size_t            i_;     // Eytzinger index, 0 at End
+    }; // class ConstIterator
+
+  private:
+    template < typename , typename , class , template < typename > class , class >
+    friend class OAA;   // OAA::Freeze() builds through Build()
+
+    explicit FrozenOAA (P p) : keys_(1), data_(1), pred_(p), n_(0) {}
+
+    // fills slots of the subtree at k in order, taking entries from i
+    template < class I >
+    void   Build    (I& i, size_t k);
+
+    // search loop: the Eytzinger index of the first key not before k (Lower)
+    // or after k (Upper), 0 if there is none
+    template < class KK >
+    size_t Lower    (const KK& k) const;
+    template < class KK >
+    size_t Upper    (const KK& k) const;
+
+    template < class KK >
+    size_t FindIndex (const KK& k) const
+    {
+      size_t i = Lower(k);
+      return (i != 0 && !pred_(k, keys_[i])) ? i : 0;
+    }
+    template < class KK >
+    const D* FindData (const KK& k) const
+    {
+      size_t i = FindIndex(k);
+      return (i == 0) ? nullptr : &data_[i];
+    }
+    template < class KK >
+    bool RetrieveKey (const KK& k, DataType& d) const
+    {
+      size_t i = FindIndex(k);
+      if (i == 0) return false;
+      d = data_[i];
+      return true;
+    }
+
+    void   Prefetch (size_t i) const;
+    size_t First    () const;          // leftmost, 0 if empty
+    size_t Last     () const;          // rightmost
+    size_t Next     (size_t i) const;  // in-order successor; from 0 to First()
+    size_t Prev     (size_t i) const;  // in-order predecessor; from 0 to Last()
+
+    static size_t Climb (size_t i);    // drop trailing 1 bits and one more
+
+    // Prefetch(i) fetches the descendants of i that fill one cache line,
+    // Spread = 2^d of them d levels down (16, 4 levels, for 4-byte keys)
+    static const size_t Spread = Pow2Floor(64 / sizeof(K));
+
+    std::vector<K>  keys_;   // keys_[1 .. n_] in Eytzinger order; slot 0 unused
+    std::vector<D>  data_;   // data_[i] belongs to keys_[i]
+    P               pred_;
+    size_t          n_;
+  }; // class FrozenOAA<>
+
+  // OAA::Freeze(), declared in oaa.h
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  FrozenOAA<K,D,P> OAA<K,D,P,A,M>::Freeze () const
+  // O(n): one in-order pass over the alive nodes, no comparisons
+  {
+    FrozenOAA<K,D,P> f(pred_);
+    f.n_ = Size();
+    f.keys_.resize(f.n_ + 1);
+    f.data_.resize(f.n_ + 1);
+    ConstIterator i = Begin();
+    f.Build(i, 1);
+    return f;
+  }
+
+  template < typename K , typename D , class P >
+  template < class I >
+  void FrozenOAA<K,D,P>::Build (I& i, size_t k)
+  // in-order over the implicit tree meets the slots in key order
+  {
+    if (k > n_) return;
+    Build(i, 2*k);
+    keys_[k] = i.Key();
+    data_[k] = i.Data();
+    ++i;
+    Build(i, 2*k + 1);
+  }
+
+  template < typename K , typename D , class P >
+  void FrozenOAA<K,D,P>::Prefetch (size_t i) const
+  {
+#if defined(__GNUC__)
+    size_t j = i * Spread;
+    if (j <= n_)
+      __builtin_prefetch(&keys_[j]);
+#else
+    (void)i;
+#endif
+  }
+
+  template < typename K , typename D , class P >
+  size_t FrozenOAA<K,D,P>::Climb (size_t i)
+  {
+#if defined(__GNUC__)
+    return i >> __builtin_ffsll((long long)~i);
+#else
+    while (i & 1) i >>= 1;
+    return i >> 1;
+#endif
+  }
+
+  template < typename K , typename D , class P >
+  template < class KK >
+  size_t FrozenOAA<K,D,P>::Lower (const KK& k) const
+  {
+    size_t i = 1;
+    while (i <= n_)
+    {
+      Prefetch(i);
+      i = 2*i + (size_t)pred_(keys_[i], k);
+    }
+    return Climb(i);
+  }
+
+  template < typename K , typename D , class P >
+  template < class KK >
+  size_t FrozenOAA<K,D,P>::Upper (const KK& k) const
+  {
+    size_t i = 1;
+    while (i <= n_)
+    {
+      Prefetch(i);
+      i = 2*i + (size_t)!pred_(k, keys_[i]);
+    }
+    return Climb(i);
+  }
+
+  template < typename K , typename D , class P >
+  size_t FrozenOAA<K,D,P>::First () const
+  {
+    if (n_ == 0) return 0;
+    size_t i = 1;
+    while (2*i <= n_) i = 2*i;
+    return i;
+  }
+
+  template < typename K , typename D , class P >
+  size_t FrozenOAA<K,D,P>::Last () const
+  {
+    if (n_ == 0) return 0;
+    size_t i = 1;
+    while (2*i + 1 <= n_) i = 2*i + 1;
+    return i;
+  }
+
+  template < typename K , typename D , class P >
+  size_t FrozenOAA<K,D,P>::Next (size_t i) const
+  // leftmost of the right subtree, or else up past the right turns
+  {
+    if (i == 0) return First();
+    if (2*i + 1 <= n_)
+    {
+      i = 2*i + 1;
+      while (2*i <= n_) i = 2*i;
+      return i;
+    }
+    return Climb(i);
+  }
+
+  template < typename K , typename D , class P >
+  size_t FrozenOAA<K,D,P>::Prev (size_t i) const
+  {
+    if (i == 0) return Last();
+    if (2*i <= n_)
+    {
+      i = 2*i;
+      while (2*i + 1 <= n_) i = 2*i + 1;
+      return i;
+    }
+    while (i != 0 && (i & 1) == 0) i >>= 1;  // up past the left turns
+    return i >> 1;
+  }
+
+  template < typename K , typename D , class P >
+  void FrozenOAA<K,D,P>::Display (std::ostream& os, int kw, int dw, std::ios_base::fmtflags kf, std::ios_base::fmtflags df) const
+  {
+    for (ConstIterator i = Begin(); i != End(); ++i)
+    {
+      os.setf(kf,std::ios_base::adjustfield);
+      os << std::setw(kw) << i.Key();
+      os.setf(df,std::ios_base::adjustfield);
+      os << std::setw(dw) << i.Data();
+      os << '\n';
+    }
+  }
+
+} // namespace fsu
+
+#endif
@@ -0,0 +1,359 @@
+/*
+    hashcount.h
+    10/16/26
+
+    HashCounter: a lock-free hash table of word counts, for counting from
+    many threads at once. It keeps no order; LoadInto(table) bulk-loads the
+    counts into an OAA afterwards for the ordered report.
+
+    Layout
+    ------
+    Open addressing with linear probing. A slot is an atomic pointer to a
+    word (its hash, length and characters, allocated once) and an atomic
+    count. A new word is claimed with one compare-and-swap on the first
+    empty slot of its probe sequence; a word already there is counted with
+    one fetch_add and no allocation, so threads counting the same words
+    never wait for each other.
+
+    Growth
+    ------
+    The table is a list of levels, each twice the size of the one before.
+    Nothing is moved when the table grows, so growing never stops other
+    threads. Once a level holds more words than its limit it takes no new
+    ones: the next thread to find an empty slot there seals it (a CAS
+    from empty to Sealed) and goes on to the next level, which the first
+    thread to need it creates. Each empty slot is decided once, claimed or
+    sealed, and every thread probing for a word takes the same path through
+    the levels, so a word is never stored twice. Lookups stop at the first
+    empty slot and pass on at a sealed one. Frequent words are claimed early
+    and stay in the small first levels.
+
+    Interface
+    ---------
+    Increment and Count may be called from any number of threads. Size may
+    also be called but lags behind words still being claimed. Traverse,
+    LoadInto and Clear need the counting to be over.
+*/
+
+#ifndef _HASHCOUNT_H
+#define _HASHCOUNT_H
+
+#include <cstddef>    // size_t
+#include <cstdint>    // uint64_t, uintptr_t
+#include <cstdlib>    // calloc, free
+#include <cstring>    // memcpy, memcmp
+#include <new>        // std::nothrow
+#include <iostream>
+#include <atomic>
+#include <type_traits>
+#include <algorithm>  // sort
+#include <utility>    // pair
+#include <vector>
+#include <strview.h>
+#include <oaa.h>      // Accumulate
+
+namespace fsu
+{
+
+  class HashCounter
+  {
+  public:
+    static const size_t MinCapacity = 1024;  // slots in the first level
+    static const size_t MaxLevels   = 40;
+
+    explicit HashCounter (size_t capacity = MinCapacity);
+    ~HashCounter         () { Clear(); }
+
+    // safe for concurrent callers; Increment returns the count after its own
+    // delta, or 0 if memory ran out
+    size_t Increment (StringView w, size_t delta = 1);
+    size_t Count     (StringView w) const;
+    size_t Size      () const;   // distinct words
+
+    // after counting
+    template < class F >  // f(word, count) for every word, in no order
+    void   Traverse  (F f) const;
+    template < class T >  // adds the counts to an OAA whose predicate takes StringViews
+    void   LoadInto  (T& table) const;
+    void   Clear     ();
+
+    size_t NumLevels () const;
+    size_t Capacity  () const;   // slots over all levels
+
+    static uint64_t Hash (const char* s, size_t n);
+
+  private:
+    HashCounter (const HashCounter&);
+    HashCounter& operator= (const HashCounter&);
+
+    struct Word     // header; the characters follow it in the same block
+    {
+      uint64_t hash_;
+      size_t   size_;
+      const char* Chars () const { return reinterpret_cast<const char*>(this + 1); }
+    };
+
+    struct Slot
+    {
+      std::atomic<Word*>  word_;   // nullptr (empty), Sealed() or the word
+      std::atomic<size_t> count_;
+    };
+
+    // GetLevel relies on these to take slots from calloc (see there)
+    static_assert(std::is_trivially_default_constructible<Slot>::value &&
+                  std::is_trivially_destructible<Slot>::value,
+                  "HashCounter: Slot must be trivial to live in calloc'd memory");
+    static_assert(ATOMIC_POINTER_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2 &&
+                  ATOMIC_LONG_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+                  "HashCounter: atomics must be lock-free, so zero bytes are an empty slot");
+
+    struct Level
+    {
+      size_t              mask_;   // slots - 1
+      size_t              limit_;  // words taken before the level is sealed
+      std::atomic<size_t> used_;
+      Slot *              slots_;
+    };
+
+    static Word*  Sealed  () { return reinterpret_cast<Word*>(std::uintptr_t(1)); }
+    static Word*  NewWord (StringView w, uint64_t h);
+    static bool   Same    (const Word* x, StringView w, uint64_t h)
+    {
+      return x->hash_ == h && x->size_ == w.Size() && std::memcmp(x->Chars(), w.Data(), w.Size()) == 0;
+    }
+    Level *       GetLevel (size_t i);  // creates it if need be; nullptr on failure
+
+    std::atomic<Level*> levels_[MaxLevels];
+    size_t              capacity_;      // slots in the first level
+  }; // class HashCounter
+
+  inline HashCounter::HashCounter (size_t capacity) : capacity_(MinCapacity)
+  {
+    while (capacity_ < capacity)
+      capacity_ *= 2;
+    for (size_t i = 0; i < MaxLevels; ++i)
+      levels_[i].store(nullptr, std::memory_order_relaxed);
+  }
+
+  inline size_t HashCounter::Increment (StringView w, size_t delta)
+  {
+    uint64_t h = Hash(w.Data(), w.Size());
+    Word * mine = nullptr;   // made at the first empty slot, kept if the CAS loses
+    for (size_t i = 0; i < MaxLevels; ++i)
+    {
+      Level * l = GetLevel(i);
+      if (l == nullptr) break;
+      size_t pos = h & l->mask_;
+      for (size_t probes = 0; probes <= l->mask_; ++probes, pos = (pos + 1) & l->mask_)
+      {
+        Slot& s = l->slots_[pos];
+        Word * x = s.word_.load(std::memory_order_acquire);
+        if (x == nullptr)
+        {
+          if (l->used_.load(std::memory_order_relaxed) >= l->limit_)
+          {
+            if (s.word_.compare_exchange_strong(x, Sealed(), std::memory_order_acq_rel))
+              break;
+          }
+          else
+          {
+            if (mine == nullptr && (mine = NewWord(w, h)) == nullptr)
+              return 0;
+            if (s.word_.compare_exchange_strong(x, mine, std::memory_order_acq_rel))
+            {
+              l->used_.fetch_add(1, std::memory_order_relaxed);
+              return s.count_.fetch_add(delta, std::memory_order_relaxed) + delta;
+            }
+          }
+          // x is now what another thread put in the slot first
+        }
+        if (x == Sealed())
+          break;
+        if (Same(x, w, h))
+        {
+          ::operator delete(mine);
+          return s.count_.fetch_add(delta, std::memory_order_relaxed) + delta;
+        }
+      }
+    }
+    ::operator delete(mine);
+    std::cerr << "** HashCounter: no level left for a word\n";
+    return 0;
+  }
+
+  inline size_t HashCounter::Count (StringView w) const
+  {
+    uint64_t h = Hash(w.Data(), w.Size());
+    for (size_t i = 0; i < MaxLevels; ++i)
+    {
+      const Level * l = levels_[i].load(std::memory_order_acquire);
+      if (l == nullptr) return 0;
+      size_t pos = h & l->mask_;
+      for (size_t probes = 0; probes <= l->mask_; ++probes, pos = (pos + 1) & l->mask_)
+      {
+        const Slot& s = l->slots_[pos];
+        const Word * x = s.word_.load(std::memory_order_acquire);
+        if (x == nullptr)  return 0;   // never sealed, so not in a later level either
+        if (x == Sealed()) break;
+        if (Same(x, w, h)) return s.count_.load(std::memory_order_relaxed);
+      }
+    }
+    return 0;
+  }
+
+  inline size_t HashCounter::Size () const
+  {
+    size_t n = 0;
+    for (size_t i = 0; i < MaxLevels; ++i)
+    {
+      const Level * l = levels_[i].load(std::memory_order_acquire);
+      if (l == nullptr) break;
+      n += l->used_.load(std::memory_order_relaxed);
+    }
+    return n;
+  }
+
+  template < class F >
+  void HashCounter::Traverse (F f) const
+  {
+    for (size_t i = 0; i < MaxLevels; ++i)
+    {
+      const Level * l = levels_[i].load(std::memory_order_acquire);
+      if (l == nullptr) break;
+      for (size_t j = 0; j <= l->mask_; ++j)
+      {
+        const Word * x = l->slots_[j].word_.load(std::memory_order_relaxed);
+        if (x != nullptr && x != Sealed())
+          f(StringView(x->Chars(), x->size_), l->slots_[j].count_.load(std::memory_order_relaxed));
+      }
+    }
+  }
+
+  template < class T >
+  void HashCounter::LoadInto (T& table) const
+  /*
+    The words are sorted by the table's predicate as StringViews, made into
+    keys in that order and merged in with InsertSorted; a word already in
+    the table has the count added to it.
+  */
+  {
+    typedef typename T::KeyType  K;
+    typedef typename T::DataType D;
+    std::vector< std::pair<StringView,D> > v;
+    v.reserve(Size());
+    Traverse([&v](StringView w, size_t n) { v.push_back(std::make_pair(w, (D)n)); });
+    typename T::PredicateType p;
+    std::sort(v.begin(), v.end(),
+              [&p](const std::pair<StringView,D>& a, const std::pair<StringView,D>& b) { return p(a.first, b.first); });
+    std::vector< std::pair<K,D> > kv;
+    kv.reserve(v.size());
+    for (size_t i = 0; i < v.size(); ++i)
+      kv.push_back(std::make_pair(K(v[i].first), v[i].second));
+    table.InsertSorted(kv.begin(), kv.end(), Accumulate<D>());
+  }
+
+  inline void HashCounter::Clear ()
+  {
+    for (size_t i = 0; i < MaxLevels; ++i)
+    {
+      Level * l = levels_[i].load(std::memory_order_relaxed);
+      if (l == nullptr) break;
+      for (size_t j = 0; j <= l->mask_; ++j)
+      {
+        Word * x = l->slots_[j].word_.load(std::memory_order_relaxed);
+        if (x != Sealed())
+          ::operator delete(x);
+      }
+      std::free(l->slots_);
+      delete l;
+      levels_[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  inline size_t HashCounter::NumLevels () const
+  {
+    size_t i = 0;
+    while (i < MaxLevels && levels_[i].load(std::memory_order_acquire) != nullptr)
+      ++i;
+    return i;
+  }
+
+  inline size_t HashCounter::Capacity () const
+  {
+    size_t n = 0;
+    for (size_t i = 0; i < NumLevels(); ++i)
+      n += levels_[i].load(std::memory_order_acquire)->mask_ + 1;
+    return n;
+  }
+
+  inline uint64_t HashCounter::Hash (const char* s, size_t n)
+  // eight bytes at a time, each word mixed in with a multiply and a shift
+  {
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ n;
+    uint64_t w;
+    for (; n >= 8; s += 8, n -= 8)
+    {
+      std::memcpy(&w, s, 8);
+      h = (h ^ w) * 0xFF51AFD7ED558CCDull;
+      h ^= h >> 32;
+    }
+    w = 0;
+    std::memcpy(&w, s, n);
+    h = (h ^ w) * 0xC4CEB9FE1A85EC53ull;
+    return h ^ (h >> 29);
+  }
+
+  inline HashCounter::Word* HashCounter::NewWord (StringView w, uint64_t h)
+  {
+    Word * x = static_cast<Word*>(::operator new(sizeof(Word) + w.Size(), std::nothrow));
+    if (x == nullptr)
+    {
+      std::cerr << "** HashCounter memory allocation failure\n";
+      return nullptr;
+    }
+    x->hash_ = h;
+    x->size_ = w.Size();
+    std::memcpy(const_cast<char*>(x->Chars()), w.Data(), w.Size());
+    return x;
+  }
+
+  inline HashCounter::Level* HashCounter::GetLevel (size_t i)
+  /*
+    Threads that find the level missing race to install one; the losers
+    free theirs. The slots come from calloc rather than new Slot[n]() so
+    that a level costs only the pages it touches: a big level's pages stay
+    the system's zero pages until words reach them, and a lost level costs
+    little. That needs zero bytes to be an empty slot. A lock-free atomic
+    is its value's bytes with no lock beside them, and Slot is trivial, so
+    starting each slot's lifetime with a default-initializing placement new
+    writes nothing and leaves the zeros as nullptr and 0 (the static_asserts
+    on Slot check both).
+  */
+  {
+    Level * l = levels_[i].load(std::memory_order_acquire);
+    if (l != nullptr) return l;
+    size_t n = capacity_ << i;
+    Slot * slots = static_cast<Slot*>(std::calloc(n, sizeof(Slot)));
+    Level * fresh = (slots == nullptr) ? nullptr : new(std::nothrow) Level;
+    if (fresh == nullptr)
+    {
+      std::free(slots);
+      std::cerr << "** HashCounter memory allocation failure\n";
+      return nullptr;
+    }
+    for (size_t j = 0; j < n; ++j)
+      new(&slots[j]) Slot;   // no stores; the slots read the zeros as empty
+    fresh->mask_ = n - 1;
+    fresh->limit_ = n - n / 4 - n / 8;    // 5/8 full
+    fresh->used_.store(0, std::memory_order_relaxed);
+    fresh->slots_ = slots;
+    if (levels_[i].compare_exchange_strong(l, fresh, std::memory_order_acq_rel))
+      return fresh;
+    std::free(slots);
+    delete fresh;
+    return l;
+  }
+
+} // namespace fsu
+
+#endif
@@ -0,0 +1,201 @@
+/*
+    inlstr.h
+    10/16/26
+
+    InlineString: a string key that keeps up to 15 characters inside itself.
+
+    An fsu::String key holds a pointer to characters in a separate heap
+    block, so every comparison in a tree descent chases a second pointer,
+    and every distinct word costs a second allocation. Most words of running
+    text are short, so InlineString stores them in its own 16 bytes:
+
+      short (size <= 15)   bytes 0..14  the characters, zero padded
+                           byte  15     15 - size (so byte 15 is the
+                                        terminator when size == 15)
+      long  (size > 15)    bytes 0..7   pointer to a heap copy, zero ended
+                           bytes 8..11  size (so at most 2^32 - 1)
+                           byte  15     LONG (0xFF)
+
+    As a key in an OAA node the short characters sit in the node itself.
+
+    Comparison is the unsigned byte order of memcmp (shorter first on a
+    tie), the order of StringView and StringLess. Two short strings compare
+    as two pairs of big-endian 64-bit words: the zero padding sorts below
+    every character, and on a tie over all 15 bytes the shorter string is a
+    prefix of the longer, which byte 15 (turned back into the size) orders
+    first. Anything involving a long string falls back to memcmp.
+
+    ThreeWay<InlineString> (the predicate to use with OAA) is transparent
+    and three-way, so OAA<InlineString,D,ThreeWay<InlineString>> is probed
+    with StringViews like OAA<String,D,StringLess> is.
+*/
+
+#ifndef _INLSTR_H
+#define _INLSTR_H
+
+#include <cstddef>    // size_t
+#include <cstdint>    // uint32_t, uint64_t
+#include <cstring>    // memcpy, memcmp, memset, strlen
+#include <iostream>
+#include <xstring.h>
+#include <strview.h>
+#include <compare3.h>
+
+namespace fsu
+{
+
+  class InlineString
+  {
+  public:
+    static const size_t MaxInline = 15;
+
+    InlineString  ()                       { SetEmpty(); }
+    InlineString  (const char* s)          { Init(s, std::strlen(s)); }
+    InlineString  (const char* s, size_t n){ Init(s, n); }
+    InlineString  (const String& s)        { Init(s.Cstr(), s.Size()); }
+    explicit InlineString (StringView v)   { Init(v.Data(), v.Size()); } // explicit: see ThreeWay below
+    InlineString  (const InlineString& s)  { Init(s.Data(), s.Size()); }
+    InlineString  (InlineString&& s)       { std::memcpy(buf_, s.buf_, sizeof(buf_)); s.SetEmpty(); }
+    ~InlineString ()                       { Free(); }
+
+    InlineString& operator = (const InlineString& s);
+    InlineString& operator = (InlineString&& s);
+
+    size_t      Size     () const { return IsLong() ? LongSize() : MaxInline - (unsigned char)buf_[MaxInline]; }
+    size_t      Length   () const { return Size(); }
+    bool        Empty    () const { return Size() == 0; }
+    bool        IsInline () const { return !IsLong(); }
+    const char* Data     () const { return IsLong() ? LongPtr() : buf_; }
+    const char* Cstr     () const { return Data(); }  // always zero ended
+    char        Element  (size_t i) const { return i < Size() ? Data()[i] : '\0'; }
+    char        operator [] (size_t i) const { return Data()[i]; }
+
+    operator StringView () const { return StringView(Data(), Size()); }
+
+    // negative, zero or positive as a is before, equal to or after b
+    static int  Compare (const InlineString& a, const InlineString& b);
+    static bool Equal   (const InlineString& a, const InlineString& b);
+
+  private:
+    static const unsigned char LONG = 0xFF;
+
+    bool        IsLong   () const { return (unsigned char)buf_[MaxInline] == LONG; }
+    const char* LongPtr  () const { const char* p; std::memcpy(&p, buf_, sizeof(p)); return p; }
+    size_t      LongSize () const { uint32_t n; std::memcpy(&n, buf_ + 8, sizeof(n)); return n; }
+
+    void SetEmpty () { std::memset(buf_, 0, sizeof(buf_)); buf_[MaxInline] = (char)MaxInline; }
+    void Init     (const char* s, size_t n);
+    void Free     () { if (IsLong()) delete [] LongPtr(); }
+
+    static uint64_t Word (const char* p);  // 8 bytes at p as a big-endian number
+
+    alignas(8) char buf_[16];
+  }; // class InlineString
+
+  inline void InlineString::Init (const char* s, size_t n)
+  {
+    std::memset(buf_, 0, sizeof(buf_));
+    if (n <= MaxInline)
+    {
+      if (n != 0) std::memcpy(buf_, s, n);
+      buf_[MaxInline] = (char)(MaxInline - n);
+      return;
+    }
+    char * p = new char [n + 1];
+    std::memcpy(p, s, n);
+    p[n] = '\0';
+    uint32_t size = (uint32_t)n;
+    std::memcpy(buf_, &p, sizeof(p));
+    std::memcpy(buf_ + 8, &size, sizeof(size));
+    buf_[MaxInline] = (char)LONG;
+  }
+
+  inline InlineString& InlineString::operator = (const InlineString& s)
+  {
+    if (this != &s)
+    {
+      InlineString t(s);
+      *this = std::move(t);
+    }
+    return *this;
+  }
+
+  inline InlineString& InlineString::operator = (InlineString&& s)
+  {
+    if (this != &s)
+    {
+      Free();
+      std::memcpy(buf_, s.buf_, sizeof(buf_));
+      s.SetEmpty();
+    }
+    return *this;
+  }
+
+  inline uint64_t InlineString::Word (const char* p)
+  {
+    uint64_t w;
+    std::memcpy(&w, p, sizeof(w));
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    return __builtin_bswap64(w);
+#elif defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return w;
+#else
+    w = 0;
+    for (size_t i = 0; i < 8; ++i)
+      w = (w << 8) | (unsigned char)p[i];
+    return w;
+#endif
+  }
+
+  inline int InlineString::Compare (const InlineString& a, const InlineString& b)
+  {
+    if (!a.IsLong() && !b.IsLong())
+    {
+      uint64_t x = Word(a.buf_), y = Word(b.buf_);
+      if (x != y) return (x < y) ? -1 : 1;
+      x = Word(a.buf_ + 8) ^ MaxInline;  // low byte: 15 - size back to size
+      y = Word(b.buf_ + 8) ^ MaxInline;
+      return (x < y) ? -1 : (x > y);
+    }
+    return StringView::Compare(StringView(a.Data(), a.Size()), StringView(b.Data(), b.Size()));
+  }
+
+  inline bool InlineString::Equal (const InlineString& a, const InlineString& b)
+  {
+    if (!a.IsLong() && !b.IsLong())
+      return std::memcmp(a.buf_, b.buf_, sizeof(a.buf_)) == 0;
+    return a.Size() == b.Size() && std::memcmp(a.Data(), b.Data(), a.Size()) == 0;
+  }
+
+  inline bool operator == (const InlineString& a, const InlineString& b) { return InlineString::Equal(a,b); }
+  inline bool operator != (const InlineString& a, const InlineString& b) { return !InlineString::Equal(a,b); }
+  inline bool operator <  (const InlineString& a, const InlineString& b) { return InlineString::Compare(a,b) < 0; }
+  inline bool operator >  (const InlineString& a, const InlineString& b) { return InlineString::Compare(a,b) > 0; }
+  inline bool operator <= (const InlineString& a, const InlineString& b) { return InlineString::Compare(a,b) <= 0; }
+  inline bool operator >= (const InlineString& a, const InlineString& b) { return InlineString::Compare(a,b) >= 0; }
+
+  inline std::ostream& operator << (std::ostream& os, const InlineString& s)
+  {
+    return os << s.Cstr();  // a plain C string, so setw pads it like String
+  }
+
+  /*
+    Two InlineStrings take the word path; anything else meets as two
+    StringViews. InlineString does not convert implicitly from StringView,
+    so a (StringView, InlineString) call has only the second overload.
+  */
+  template < >
+  class ThreeWay < InlineString >
+  {
+  public:
+    typedef void is_transparent;
+
+    bool operator () (const InlineString& a, const InlineString& b) const { return InlineString::Compare(a,b) < 0; }
+    bool operator () (StringView a, StringView b) const { return StringView::Compare(a,b) < 0; }
+    int  Compare     (const InlineString& a, const InlineString& b) const { return InlineString::Compare(a,b); }
+    int  Compare     (StringView a, StringView b) const { return StringView::Compare(a,b); }
+  };
+
+} // namespace fsu
+
+#endif
@@ -10,6 +10,8 @@
 #include <cctype>
 #include <iostream>
 #include <fstream>
+#include <vector>
+#include <limits>
 
 void  DisplayMenu ();
 
@@ -35,6 +37,9 @@ int main( int argc, char* argv[] )
   WordBench wb;       // declaring WordBench2 object
   char selection;  
   fsu::String filename;  
+  long threads;
+  char answer;
+  std::vector<fsu::String> paths, failed;
 
   do
   {
@@ -57,6 +62,38 @@ int main( int argc, char* argv[] )
         }
         break;
        
+      case 'b': case 'B':
+        std::cout << "  Enter file names, then '#' : ";
+        paths.clear();
+        failed.clear();
+        while (*isptr >> filename && filename != "#")
+        {
+          if (BATCH) std::cout << filename << ' ';
+          paths.push_back(filename);
+        }
+        if (BATCH) std::cout << "#\n";
+        if (!wb.ReadTexts(paths, &failed))
+          for (size_t i = 0; i < failed.size(); ++i)
+            std::cout << "    ** Cannot open file " << failed[i] << '\n';
+        break;
+
+      case 'd': case 'D':
+        std::cout << "  Enter directory name : ";
+        *isptr >> filename;
+        if (BATCH) std::cout << filename << '\n';
+        std::cout << "  Include subdirectories (y/n) : ";
+        *isptr >> answer;
+        if (BATCH) std::cout << answer << '\n';
+        failed.clear();
+        if (!wb.ReadDirectory(filename, answer == 'y' || answer == 'Y', &failed))
+        {
+          if (failed.empty())
+            std::cout << "    ** Cannot open directory " << filename << '\n';
+          for (size_t i = 0; i < failed.size(); ++i)
+            std::cout << "    ** Cannot open file " << failed[i] << '\n';
+        }
+        break;
+
       case 'w': case 'W': 
         std::cout << "  Enter file name: ";
         *isptr >> filename;
@@ -79,6 +116,36 @@ int main( int argc, char* argv[] )
         wb.ShowSummary();
         break;
      
+      case 'h': case 'H':
+        wb.SetStore(wb.GetStore() == WordBench::HASH ? WordBench::TREE : WordBench::HASH);
+        std::cout << "  counting into "
+                  << (wb.GetStore() == WordBench::HASH ? "a hash table\n" : "the tree\n");
+        break;
+
+      case 't': case 'T':
+        std::cout << "  Enter number of threads : ";
+        while (!(*isptr >> threads) || threads < 1)
+        {
+          if (isptr->eof()) break;
+          if (isptr->fail())    // not a number: skip the rest of the line
+          {
+            isptr->clear();
+            isptr->ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+          }
+          else if (BATCH) std::cout << threads << '\n';
+          std::cout << "    ** Enter a number from 1 to " << WordBench::MaxThreads << " : ";
+        }
+        if (isptr->fail())      // input ran out
+        {
+          std::cout << "\n     ** No number of threads given\n";
+          selection = 'q';
+          break;
+        }
+        if (BATCH) std::cout << threads << '\n';
+        wb.SetThreads(threads > (long)WordBench::MaxThreads ? WordBench::MaxThreads : (unsigned)threads);
+        std::cout << "  reading with " << wb.Threads() << " thread(s)\n";
+        break;
+
       case 'm': case 'M':
         DisplayMenu();
         break;
@@ -120,9 +187,13 @@ void DisplayMenu()
             << "     WB Command                     key\n"
             << "     ----------                     ---\n"
             << "     Read a file  ................  'r'\n"
+            << "     read a Batch of files  ......  'b'\n"
+            << "     read a Directory  ...........  'd'\n"
             << "     show Summary  ...............  's'\n"
             << "     Write report  ...............  'w'\n"
             << "     Clear current data  .........  'c'\n"
+            << "     toggle Hash counting  .......  'h'\n"
+            << "     set Threads for reading  ....  't'\n"
             << "     eXit BATCH mode  ............  'x'\n"
             << "     display Menu  ...............  'm'\n"
             << "     Quit program  ...............  'q'\n";
@@ -0,0 +1,104 @@
+/*
+    mapfile.h
+    10/16/26
+
+    MappedFile: a read-only memory map of a whole file, for scanning text
+    without copying it into the process first.
+
+    Open(path) maps a regular file with mmap (an empty file maps to no
+    bytes, with Data() == nullptr) and returns false for anything else, so
+    a caller can fall back to a stream. Sequential() tells the kernel the
+    pages will be read in order, so it reads ahead and drops them early.
+    Release(begin,end) gives back the pages lying wholly within those
+    bytes. They are clean copies of the file, so a scan that releases what
+    it has passed keeps only a window of the file resident, whatever its
+    size. The bytes stay readable afterwards; they are read from the file
+    again if touched.
+*/
+
+#ifndef _MAPFILE_H
+#define _MAPFILE_H
+
+#include <cstddef>     // size_t
+#include <sys/mman.h>  // mmap, munmap, madvise, posix_madvise
+#include <sys/stat.h>  // fstat
+#include <fcntl.h>     // open
+#include <unistd.h>    // close, sysconf
+
+namespace fsu
+{
+
+  class MappedFile
+  {
+  public:
+    MappedFile  () : data_(nullptr), size_(0) {}
+    ~MappedFile () { Close(); }
+
+    bool        Open       (const char* path);
+    void        Close      ();
+    void        Sequential () const;
+    void        Release    (size_t begin, size_t end) const;
+
+    const char* Data () const { return data_; }
+    size_t      Size () const { return size_; }
+
+  private:
+    MappedFile (const MappedFile&);
+    MappedFile& operator= (const MappedFile&);
+
+    char * data_;
+    size_t size_;
+  }; // class MappedFile
+
+  inline bool MappedFile::Open (const char* path)
+  {
+    Close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+      ::close(fd);
+      return false;
+    }
+    if (st.st_size > 0)
+    {
+      void * p = ::mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED)
+      {
+        ::close(fd);
+        return false;
+      }
+      data_ = static_cast<char*>(p);
+      size_ = (size_t)st.st_size;
+    }
+    ::close(fd);   // the mapping keeps the file
+    return true;
+  }
+
+  inline void MappedFile::Close ()
+  {
+    if (data_ != nullptr)
+      ::munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  inline void MappedFile::Sequential () const
+  {
+    if (data_ != nullptr)
+      ::posix_madvise(data_, size_, POSIX_MADV_SEQUENTIAL);
+  }
+
+  inline void MappedFile::Release (size_t begin, size_t end) const
+  {
+    size_t page = (size_t)::sysconf(_SC_PAGESIZE);
+    begin = (begin + page - 1) / page * page;   // whole pages only
+    end = (end < size_) ? end / page * page : size_;
+    if (data_ != nullptr && begin < end)
+      ::madvise(data_ + begin, end - begin, MADV_DONTNEED);
+  }
+
+} // namespace fsu
+
+#endif
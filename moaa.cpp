@@ -42,6 +42,7 @@
 #include <iostream>
 #include <iomanip>
 #include <oaa.h>
+#include <poaa.h>
 #include <cmath>
 
 // choose one from group A 
@@ -71,12 +72,16 @@ const      unsigned int putPercent  =       50;    // growth rate
 const      unsigned int assignPercent  =    30;    // and volatility
 // */
 
+// choose the container under test
+
+typedef fsu::OAA<KeyType,DataType>           Container;
+// typedef fsu::PersistentOAA<KeyType,DataType> Container;  // copies share nodes
+
 // constants for number of containers and operations
 const unsigned int numObj = 3;  // containers x0, x1, x2
 const unsigned int numOps = 4; // operations 0..3
 
-template < typename T , class P >
-void WriteReport(fsu::OAA<T,P> x, char n, unsigned long numreports);
+void WriteReport(Container x, char n, unsigned long numreports);
 
 int main(int argc, char* argv[])
 {
@@ -89,7 +94,7 @@ int main(int argc, char* argv[])
   size_t maxrpts = atoi(argv[1]);
 
   // objects
-  fsu::OAA<KeyType,DataType> x0, x1, x2;
+  Container      x0, x1, x2;
   Random_class   ranobj;
   DataType       data;
   KeyType        key;
@@ -304,8 +309,7 @@ int main(int argc, char* argv[])
   return EXIT_SUCCESS;
 }  // end main()
 
-template < typename T , class P >
-void WriteReport(fsu::OAA<T,P> x, char n, unsigned long numrpts)
+void WriteReport(Container x, char n, unsigned long numrpts)
 {
   size_t size = x.Size();
   std::cout << std::showpoint << std::fixed << std::setprecision(2);
@@ -25,26 +25,97 @@
   ------------------
     The initial development of this class is missing the implementation of:
         1) Object comparison operators == and !=
-        2) Iterators and iterator support
-        3) Remove
-    These will be implemented some time in the future. 
+    This will be implemented some time in the future. 
     The "mutator" portion of the OAA API consists of Get, Put, Clear,
     Erase and Rehash -- arguably the minimal necessary for a useful general
     purpose container.
     
     -operator[] the AA bracket operator is in the interface and is implemented
-    in-line above with a single call to Get. Also note that Put is implemented
-    with a single call to Get. Operator[], and thus Get(k), is supposed to return the data
-    associated with the key. 
+    in-line above with a single call to Get. Also note that Put locates the key
+    first: a key already present (or dead) has its data assigned in place, and
+    only a missing key goes down the insert path (RGet), where its data is built
+    straight from the argument. Operator[], and thus Get(k), is supposed to
+    return the data associated with the key. 
     
     - Get(key) returns the data associated with the key. It ensures that the
       key is in the set and it also retrieves the value when it is found. In
       other words, it ensures that the key is in the set and returns a reference
       to the data already stored, thus allowing modification.
 
+    - Node storage comes from the allocator policy A (see slaballoc.h). The
+      default SlabAllocator carves nodes out of large slabs and recycles freed
+      nodes, so Clear() and ~OAA() give back all storage at once. Reserve(n)
+      makes room for n nodes up front; BytesInUse() reports node storage.
+
+    - Erase(key) is lazy: the node is marked dead and its data reset, and the
+      tree shape is left alone. A later Get of the same key revives the node.
+      Dead nodes still lengthen search paths, so when the RehashPolicy sees
+      too large a share of dead nodes (DeadRatio: by default more than half of
+      at least 64 nodes) Erase calls Rehash, which drops them all.
+
+    - Iterator and ConstIterator visit the alive nodes in key order in both
+      directions. An iterator keeps the path from the root to its node on a
+      stack, so a step costs amortized O(1) and never needs parent links.
+      LowerBound(k) (first key >= k), UpperBound(k) (first key > k) and
+      EqualRange(k) start an iterator from a single descent, so a range or
+      prefix scan costs O(log n + k). End() and rEnd() are the same null
+      position: ++ from there goes to the first key, -- to the last.
+      Any Get of a new key, Rehash or Clear invalidates iterators, and so
+      does an Erase that triggers a Rehash (see DeadRatio below), including
+      iterators from LowerBound and EqualRange.
+
+    - With M = OrderStats<Mon> every node also carries its subtree's alive
+      count and Mon aggregate (see NoAugment below), giving O(log n) Rank(k),
+      Select(i) and SumRange(lo,hi). Put, Upsert, Increment and Erase keep
+      the aggregates current. Data changed through a reference from Get,
+      operator[] or an Iterator cannot be seen, so those calls mark the
+      aggregates stale and the next SumRange recomputes them once, in O(n).
+      Rank and Select depend only on counts and are always current. With the
+      default NoAugment all of this compiles away.
+
+    - Keys and data can be moved in: Get, operator[], Put, Upsert and
+      Increment take rvalue keys, and Emplace(k, args...) builds the data of a
+      new key in place. A key is moved only when a node is created for it.
+      An OAA itself moves (and Swaps) in O(1), taking its node storage along.
+
+    - With a transparent predicate (one declaring is_transparent, such as
+      StringLess from strview.h) Find, Contains, Retrieve, Get, operator[],
+      Upsert and Increment accept any key-like type the predicate can compare with K,
+      e.g. OAA<String,D,StringLess>::Increment(StringView(p,n)). No K is
+      constructed unless a node is created.
+
+    - FindBatch(keys,n,out) and GetBatch(keys,n,out) resolve a whole batch
+      of keys, interleaving up to BatchWidth descents so that one search's
+      cache miss overlaps with the others' work (AMAC style).
+
+    - InsertSorted(first,last,c) merges a sorted batch of pairs into the
+      table by splitting the tree around the batch and joining the pieces
+      back, so m keys into n nodes cost O(m log(n/m + 1)) rather than m
+      descents from the root; keys already present are combined with c.
+
+    - Merge(std::move(a),c) moves all of another table into this one in
+      linear time: both trees are flattened, merged like two sorted lists
+      (c combines the data of a key in both) and rebuilt. a's nodes are
+      reused, so nothing is allocated.
+
+    - Split(k) cuts the table into the keys below k and the rest, and
+      Join(lo,hi) puts two such tables back together, both in O(log n) by
+      relinking nodes. The pieces share the original node storage (see
+      slaballoc.h) and may be used from different threads; their sizes are
+      counted, once, when first asked for.
+
+    - Freeze() copies the alive entries, in O(n), into a FrozenOAA (see
+      frozenoaa.h): an immutable array in breadth-first order that answers
+      Find and LowerBound faster than the tree and iterates in key order.
+
+    - A predicate with a three-way Compare(a,b) (ThreeWay<T> in compare3.h,
+      StringLess) is used as such: Get, Find and the rest compare once per
+      level instead of up to twice. LowerBound, UpperBound and Rank already
+      need only one less-than per level and use pred_ as before.
+
   OAA Private Methods
   -------------------
-  RGet(node,k,location) is called in Get(key) and in RInsert(node,k,d) and works
+  RGet(node,k,location,args...) is called in Get(key) and in Upsert(k,f) and works
   recursively. In Get(key), RGet is always initially called as
   RGet(root_,k,location) where it begins searching from the root of the
   tree. The Node pointer for root_ in the function eventually will point to  
@@ -58,48 +129,325 @@
 #define _OAA_H
 
 #include <cstddef>    // size_t
+#include <algorithm>  // lower_bound, upper_bound
+#include <iterator>   // distance, advance
+#include <type_traits>
+#include <utility>    // std::pair
+#include <vector>     // iterator stacks
 #include <iostream>
 #include <iomanip>
 #include <compare.h>  // LessThan
 #include <queue.h>    // used in Dump()
 #include <ansicodes.h>
+#include <slaballoc.h> // SlabAllocator, HeapAllocator
 
 namespace fsu
 {
-  template < typename K , typename D , class P >
+  template < typename K , typename D , class P , template < typename > class A , class M >
   class OAA;
 
-  template < typename K , typename D , class P = LessThan<K> >
+  template < typename K , typename D , class P >
+  class FrozenOAA;   // frozenoaa.h
+
+  // default rehash policy for Erase: compact once dead nodes exceed ratio_ of
+  // all nodes, but only for trees of at least min_ nodes; ratio_ >= 1 disables
+  class DeadRatio
+  {
+  public:
+    explicit DeadRatio (double ratio = 0.5, size_t min = 64) : ratio_(ratio), min_(min) {}
+    bool operator() (size_t numNodes, size_t numDead) const
+    {
+      return numNodes >= min_ && (double)numDead > ratio_ * (double)numNodes;
+    }
+    double Ratio () const { return ratio_; }
+    size_t Min   () const { return min_; }
+  private:
+    double ratio_;
+    size_t min_;
+  };
+
+  // ways to combine the data of duplicate keys, used as c(stored, incoming)
+  template < typename D >
+  class Replace
+  {
+  public:
+    void operator() (D& stored, const D& incoming) const { stored = incoming; }
+  };
+
+  template < typename D >
+  class Accumulate
+  {
+  public:
+    void operator() (D& stored, const D& incoming) const { stored += incoming; }
+  };
+
+  /*
+    Augmentation policies, the fifth template parameter of OAA.
+
+    NoAugment (the default) leaves the nodes as they are. OrderStats<Mon> gives
+    every node the number of alive nodes in its subtree and the Mon aggregate
+    of their (key,data) pairs, kept up to date through rotations, inserts,
+    erases and rebuilds. That is what Rank, Select and SumRange run on. A
+    monoid supplies
+
+      typedef ... ValueType;
+      static ValueType Identity ();
+      static ValueType Lift     (const K& k, const D& d);
+      static ValueType Op       (const ValueType& a, const ValueType& b); // associative
+  */
+  class NoAugment
+  {
+  public:
+    typedef char ValueType;
+  };
+
+  class CountOnly    // monoid for OrderStats when only Rank and Select are wanted
+  {
+  public:
+    typedef char ValueType;
+    static ValueType Identity () { return 0; }
+    template < typename K , typename D >
+    static ValueType Lift (const K&, const D&) { return 0; }
+    static ValueType Op (ValueType, ValueType) { return 0; }
+  };
+
+  template < typename V >
+  class SumData      // monoid: total of the data values, e.g. word occurrences
+  {
+  public:
+    typedef V ValueType;
+    static ValueType Identity () { return V(); }
+    template < typename K , typename D >
+    static ValueType Lift (const K&, const D& d) { return V(d); }
+    static ValueType Op (const ValueType& a, const ValueType& b) { return a + b; }
+  };
+
+  template < class Mon = CountOnly >
+  class OrderStats
+  {
+  public:
+    typedef Mon                       MonoidType;
+    typedef typename Mon::ValueType   ValueType;
+  };
+
+  // per-node storage for an augmentation; empty unless M is OrderStats<>
+  template < class M >
+  class AugmentData
+  {
+  public:
+    static const bool enabled = false;
+  };
+
+  template < class Mon >
+  class AugmentData < OrderStats<Mon> >
+  {
+  public:
+    static const bool enabled = true;
+    AugmentData () : count_(1), agg_(Mon::Identity()) {}
+    size_t                    count_;  // alive nodes in this subtree
+    typename Mon::ValueType   agg_;    // Mon aggregate over this subtree
+  };
+
+  // IsTransparent<P> is true when P declares is_transparent, i.e. it can
+  // compare keys with other key-like types (see StringLess in strview.h)
+  template < class T >
+  struct VoidType { typedef void type; };
+
+  template < class P , class = void >
+  struct IsTransparent : std::false_type {};
+
+  template < class P >
+  struct IsTransparent < P , typename VoidType<typename P::is_transparent>::type > : std::true_type {};
+
+  // IsThreeWay<P,K> is true when P also has int Compare(K,K) const, negative,
+  // zero or positive (see ThreeWay in compare3.h)
+  template < class P , class K , class = void >
+  struct IsThreeWay : std::false_type {};
+
+  template < class P , class K >
+  struct IsThreeWay < P , K , typename VoidType<decltype(std::declval<const P&>().Compare(
+                      std::declval<const K&>(), std::declval<const K&>()))>::type > : std::true_type {};
+
+  template < typename K , typename D , class P = LessThan<K> ,
+             template < typename > class A = SlabAllocator , class M = NoAugment >
   class OAA
   {
   public:
     typedef K    KeyType;
     typedef D    DataType;
     typedef P    PredicateType;
+    typedef M    AugmentType;
 
              OAA  ();
     explicit OAA  (P p);
              OAA  (const OAA& a);
+             OAA  (OAA&& a);
+    template < class I >                    // I iterates over pair<K,D>
+             OAA  (I first, I last, P p = P());
              ~OAA ();
     OAA& operator=(const OAA& a);
+    OAA& operator=(OAA&& a);
+    void Swap     (OAA& a);
 
     DataType& operator [] (const KeyType& k)        { return Get(k); }
+    DataType& operator [] (KeyType&& k)             { return Get(std::move(k)); }
+
+    // the rvalue forms move the key (and data) into the node only when one is
+    // created; a key already in the table is left with the caller
+    void Put (const KeyType& k , const DataType& d) { PutKey(k, d); }
+    void Put (KeyType&& k , DataType&& d)           { PutKey(std::move(k), std::move(d)); }
+    D&   Get (const KeyType& k)                     { return GetKey(k); }
+    D&   Get (KeyType&& k)                          { return GetKey(std::move(k)); }
+
+    // constructs the data of k from args if k is not in the table;
+    // returns false (and changes nothing) if it is
+    template < class... Args >
+    bool Emplace (const KeyType& k, Args&&... args) { return EmplaceKey(k, std::forward<Args>(args)...); }
+    template < class... Args >
+    bool Emplace (KeyType&& k, Args&&... args)      { return EmplaceKey(std::move(k), std::forward<Args>(args)...); }
+
+    template <class F>  //F is applied to the data of k
+    const D& Upsert    (const KeyType& k, F f) { return UpsertKey(k, f); }
+    template <class F>
+    const D& Upsert    (KeyType&& k, F f)      { return UpsertKey(std::move(k), f); }
+    const D& Increment (const KeyType& k, const DataType& delta = DataType(1));
+    const D& Increment (KeyType&& k, const DataType& delta = DataType(1));
+
+    const D* Find     (const KeyType& k) const;  // nullptr if k is not in the table
+    bool     Contains (const KeyType& k) const { return FindNode(k) != nullptr; }
+    bool     Retrieve (const KeyType& k, DataType& d) const;
+
+    // heterogeneous lookup: with a transparent P these also take any KK that
+    // P compares with K (e.g. a StringView for String keys); a K is built
+    // from k only when a new node is created
+    template < class KK >
+    using IfTransparent = typename std::enable_if<IsTransparent<P>::value, KK>::type;
+
+    template < class KK , class = IfTransparent<KK> >
+    DataType& operator [] (const KK& k)         { return GetKey(k); }
+    template < class KK , class = IfTransparent<KK> >
+    D&       Get       (const KK& k)            { return GetKey(k); }
+    template < class KK , class F , class = IfTransparent<KK> >
+    const D& Upsert    (const KK& k, F f)       { return UpsertKey(k, f); }
+    template < class KK , class = IfTransparent<KK> >
+    const D& Increment (const KK& k, const DataType& delta = DataType(1))
+    {
+      return UpsertKey(k, [&delta](DataType& d) { d += delta; });
+    }
+    template < class KK , class = IfTransparent<KK> >
+    const D* Find      (const KK& k) const
+    {
+      const Node * n = FindNode(k);
+      return (n == nullptr) ? nullptr : &n->data_;
+    }
+    template < class KK , class = IfTransparent<KK> >
+    bool     Contains  (const KK& k) const      { return FindNode(k) != nullptr; }
+    template < class KK , class = IfTransparent<KK> >
+    bool     Retrieve  (const KK& k, DataType& d) const
+    {
+      const Node * n = FindNode(k);
+      if (n == nullptr) return false;
+      d = n->data_;
+      return true;
+    }
 
-    void Put (const KeyType& k , const DataType& d) { Get(k) = d; }
-    D&   Get (const KeyType& k);
+    // batched lookup: out[i] is set for keys[i], as Find (nullptr when
+    // absent) by FindBatch and as Get (inserting) by GetBatch. Up to
+    // BatchWidth descents advance in turn, each prefetching its next node,
+    // so their cache misses overlap instead of following one another.
+    void FindBatch (const KeyType* keys, size_t n, const D** out) const
+    {
+      LocateBatch(keys, n, [out](size_t i, Node* x) { out[i] = (x != nullptr && x->IsAlive()) ? &x->data_ : nullptr; });
+    }
+    template < class KK , class = IfTransparent<KK> >
+    void FindBatch (const KK* keys, size_t n, const D** out) const
+    {
+      LocateBatch(keys, n, [out](size_t i, Node* x) { out[i] = (x != nullptr && x->IsAlive()) ? &x->data_ : nullptr; });
+    }
+    void GetBatch  (const KeyType* keys, size_t n, D** out);
 
     void Erase(const KeyType& k);
     void Clear();
     void Rehash();
 
-    bool   Empty    () const { return root_ == nullptr; }
-    size_t Size     () const { return RSize(root_); }     // counts alive nodes
-    size_t NumNodes () const { return RNumNodes(root_); } // counts nodes
+    // replace the contents with the pairs in [first,last); later duplicates
+    // are folded into earlier ones with c (default: Replace, i.e. last wins)
+    template < class I >
+    void BulkLoad (I first, I last) { BulkLoad(first, last, Replace<D>()); }
+    template < class I , class C >
+    void BulkLoad (I first, I last, C c);
+
+    // merge the pairs of [first,last), sorted by P, into the table; data for
+    // a key already present, or repeated in the range, are folded in with
+    // c(stored, incoming) (default: Replace). m keys into n cost
+    // O(m log(n/m + 1)) with a random access I
+    template < class I >
+    void InsertSorted (I first, I last) { InsertSorted(first, last, Replace<D>()); }
+    template < class I , class C >
+    void InsertSorted (I first, I last, C c);
+
+    // move every entry of a into this table, in O(n + a.Size()); for a key
+    // in both, c(stored, incoming) folds a's data into ours (default:
+    // Replace). a's nodes are reused, a is left empty, and the result is
+    // rebuilt at minimum height with no dead nodes. For a small a,
+    // InsertSorted from a's iterators does less work.
+    void Merge (OAA&& a) { Merge(std::move(a), Replace<D>()); }
+    template < class C >
+    void Merge (OAA&& a, C c);
+
+    // Split(k) moves the keys below k into the first table returned and the
+    // rest into the second, leaving this one empty; Join(lo,hi) makes this
+    // table the union of lo and hi, which are left empty, provided every key
+    // of lo is below every key of hi (else it prints an error and returns
+    // false, changing nothing). Both take O(log n): nodes are relinked, the
+    // pieces share node storage, and their sizes are counted when next asked.
+    std::pair<OAA,OAA> Split (const KeyType& k);
+    bool               Join  (OAA& lo, OAA& hi);
+
+    void Reserve(size_t n) { Recount(); alloc_.Reserve(n); } // room for n nodes in total
+
+    void             SetRehashPolicy (const DeadRatio& r) { rehash_ = r; }
+    const DeadRatio& RehashPolicy    () const             { return rehash_; }
+
+    size_t BytesInUse    () const { Recount(); return alloc_.BytesInUse(); } // node storage in use
+    size_t BytesReserved () const { Recount(); return alloc_.BytesReserved(); } // node storage held (this piece's share after a Split)
+
+    bool   Empty    () const { return Size() == 0; }
+    size_t Size     () const { Recount(); return size_; }      // counts alive nodes
+    size_t NumNodes () const { Recount(); return numNodes_; }  // counts nodes
     int    Height   () const { return RHeight(root_); }
 
     template <class F>  //F is a function object
     void   Traverse(F f) const { RTraverse(root_,f); }
 
+    // read-only snapshot of the alive entries in a search-friendly array;
+    // defined in frozenoaa.h
+    FrozenOAA<K,D,P> Freeze () const;
+
+    class Iterator;
+    class ConstIterator;
+
+    Iterator      Begin      ();
+    Iterator      End        ();
+    Iterator      rBegin     ();
+    Iterator      rEnd       ();
+    Iterator      LowerBound (const KeyType& k);
+    Iterator      UpperBound (const KeyType& k);
+    std::pair<Iterator,Iterator> EqualRange (const KeyType& k);
+
+    ConstIterator Begin      () const;
+    ConstIterator End        () const;
+    ConstIterator rBegin     () const;
+    ConstIterator rEnd       () const;
+    ConstIterator LowerBound (const KeyType& k) const;
+    ConstIterator UpperBound (const KeyType& k) const;
+    std::pair<ConstIterator,ConstIterator> EqualRange (const KeyType& k) const;
+
+    // OrderStats<> trees only, all O(log n)
+    size_t        Rank     (const KeyType& k) const;  // number of alive keys < k
+    ConstIterator Select   (size_t i) const;          // i-th alive key (from 0), End() if none
+    typename M::ValueType SumRange (const KeyType& lo, const KeyType& hi) const; // over [lo,hi)
+
     void   Display (std::ostream& os, int kw, int dw,     // key, data widths
                     std::ios_base::fmtflags kf = std::ios_base::right, // key flag
                     std::ios_base::fmtflags df = std::ios_base::right // data flag
@@ -137,16 +485,19 @@ namespace fsu
       }
     }
 
-    class Node
+    class Node : public AugmentData<M>
     {
       const KeyType   key_;
             DataType  data_;
       Node * lchild_, * rchild_;
       unsigned char flags_;
-      Node (const KeyType& k, const DataType& d, Flags flags = DEFAULT)
-        : key_(k), data_(d), lchild_(nullptr), rchild_(nullptr), flags_(flags)
+      template < class KK , class... Args >  // data_ is built from args
+      explicit Node (KK&& k, Args&&... args)
+        : key_(std::forward<KK>(k)), data_(std::forward<Args>(args)...),
+          lchild_(nullptr), rchild_(nullptr), flags_(DEFAULT)
       {}
-      friend class OAA<K,D,P>;
+      friend class OAA<K,D,P,A,M>;
+      friend class A<Node>;      // constructs nodes in place
       bool IsRed    () const { return 0 != (RED & flags_); }
       bool IsBlack  () const { return !IsRed(); }
       bool IsDead   () const { return 0 != (DEAD & flags_); }
@@ -157,188 +508,1290 @@ namespace fsu
       void SetAlive ()       { flags_ &= ~DEAD; }
     }; //Class Node
 
-    class PrintNode
+  public: // iterators
+
+    class ConstIterator
+    {
+    public:
+      ConstIterator () : path_(), root_(nullptr) {}
+
+      const KeyType&  Key   () const { return path_.back()->key_; }
+      const DataType& Data  () const { return path_.back()->data_; }
+      bool            Valid () const { return !path_.empty(); }
+
+      ConstIterator& operator ++ ()    { Next(); return *this; }
+      ConstIterator  operator ++ (int) { ConstIterator i(*this); Next(); return i; }
+      ConstIterator& operator -- ()    { Prev(); return *this; }
+      ConstIterator  operator -- (int) { ConstIterator i(*this); Prev(); return i; }
+
+      bool operator == (const ConstIterator& i) const { return Current() == i.Current(); }
+      bool operator != (const ConstIterator& i) const { return Current() != i.Current(); }
+
+    protected:
+      friend class OAA<K,D,P,A,M>;
+      explicit ConstIterator (Node * root) : path_(), root_(root) {}
+
+      Node * Current () const { return path_.empty() ? nullptr : path_.back(); }
+      void   Next    (); // to the next alive node
+      void   Prev    (); // to the previous alive node
+      void   Step    (); // to the next node, dead or alive
+      void   StepBack(); // to the previous node, dead or alive
+      void   Lowest  (Node * n);  // push the left spine of n
+      void   Highest (Node * n);  // push the right spine of n
+
+      std::vector<Node*> path_;  // root .. current node; empty at End
+      Node *             root_;
+    }; // class ConstIterator
+
+    class Iterator : public ConstIterator
+    {
+    public:
+      Iterator () : ConstIterator() {}
+
+      DataType& Data () const { return this->path_.back()->data_; }
+
+      Iterator& operator ++ ()    { this->Next(); return *this; }
+      Iterator  operator ++ (int) { Iterator i(*this); this->Next(); return i; }
+      Iterator& operator -- ()    { this->Prev(); return *this; }
+      Iterator  operator -- (int) { Iterator i(*this); this->Prev(); return i; }
+
+    private:
+      friend class OAA<K,D,P,A,M>;
+      explicit Iterator (Node * root) : ConstIterator(root) {}
+    }; // class Iterator
+
+  private:
+
+    class PrintNode
+    {
+     public:
+      PrintNode (std::ostream& os, int kw, int dw,
+                 std::ios_base::fmtflags kf, std::ios_base::fmtflags df )
+        : os_(os), kw_(kw), dw_(dw), kf_(kf), df_(df) {}
+      void operator() (const Node * n) const
+      {
+        if (n->IsAlive())
+        {
+          os_.setf(kf_,std::ios_base::adjustfield);
+          os_ << std::setw(kw_) << n->key_;
+          os_.setf(df_,std::ios_base::adjustfield);
+          os_ << std::setw(dw_) << n->data_;
+          os_ << '\n';
+        }
+      }
+     private:
+      std::ostream& os_;
+      int kw_, dw_;      // key and data column widths
+      std::ios_base::fmtflags kf_, df_; // column adjustment flags for output stream
+    }; //class PrintNode
+    
+  private: // data
+    Node *         root_;
+    PredicateType  pred_;  //Default is LessThan<K>
+    mutable A<Node> alloc_; //Default is SlabAllocator<Node>; Recount fixes its count
+    mutable size_t size_;     // alive nodes
+    mutable size_t numNodes_; // alive + dead nodes
+    DeadRatio      rehash_;   // when Erase compacts the tree
+    mutable bool   stale_;    // aggregates may be out of date (OrderStats only)
+    mutable bool   counted_;  // size_ and numNodes_ are current (false after Split)
+
+  private: // methods
+    // three-way comparison of a key with a node's key: one call to
+    // pred_.Compare when P has it, else pred_ in both directions, stopping
+    // after the first when it decides
+    typedef std::integral_constant < bool , IsThreeWay<P,K>::value > ThreeWayPredicate;
+    template < class KK >
+    int Cmp (const KK& a, const K& b) const { return Cmp(a, b, ThreeWayPredicate()); }
+    template < class KK >
+    int Cmp (const KK& a, const K& b, std::true_type) const { return pred_.Compare(a,b); }
+    template < class KK >
+    int Cmp (const KK& a, const K& b, std::false_type) const
+    {
+      return pred_(a,b) ? -1 : (pred_(b,a) ? 1 : 0);
+    }
+
+    // augmentation upkeep; all of these are no-ops unless M is OrderStats<>
+    typedef std::integral_constant < bool , AugmentData<M>::enabled > Augmented;
+    static void   Pull     (Node * n) { Pull(n, Augmented()); } // n from its children
+    static void   Pull     (Node *, std::false_type) {}
+    static void   Pull     (Node * n, std::true_type);
+    void          Fix      (const K& kval) { Fix(kval, Augmented()); } // search path of k
+    void          Fix      (const K&, std::false_type) {}
+    void          Fix      (const K& kval, std::true_type) { RFix(root_, kval); }
+    void          RFix     (Node * n, const K& kval);
+    static void   RPullAll (Node * n);
+    void          Touch    () { if (Augmented::value) stale_ = true; } // D& handed out
+    void          Refresh  () const; // recompute aggregates if stale_
+    void          Recount  () const; // recount size_ and numNodes_ unless counted_
+    static size_t Count    (const Node * n);
+    static typename M::ValueType Agg  (const Node * n);
+    static typename M::ValueType Self (const Node * n);
+    template < class KK , class... Args >
+    Node *        NewNode     (KK&& k, Args&&... args);
+    void          RRelease    (Node* n); // deletes n and all descendants of n
+    static void   RDestroy    (Node* n); // runs destructors of n and its descendants only
+    Node *        RClone      (const Node* n); // returns deep copy of n
+    static int    RHeight     (Node * n);
+
+    // rotations
+    static Node * RotateLeft  (Node * n);
+    static Node * RotateRight (Node * n);
+
+    template < class F >
+    static void   RTraverse (Node * n, F f);
+
+    // interleaved descents for FindBatch and GetBatch: finish(i, node) is
+    // called once for each i, with the node of keys[i] (alive or dead) or
+    // nullptr, in no particular order of i
+    static const size_t BatchWidth = 8;
+    template < class KK , class F >
+    void LocateBatch (const KK* keys, size_t n, F finish) const;
+
+    // iterator starts: a single descent, leaving the search path on the stack
+    void Lower (ConstIterator& i, const K& kval) const; // first node with key >= k
+    void Upper (ConstIterator& i, const K& kval) const; // first node with key > k
+
+    // iterative search; Locate returns the node holding k (alive or dead),
+    // FindNode only an alive one, both nullptr when there is none
+    template < class KK >
+    Node * Locate  (const KK& kval) const;
+    template < class KK >
+    Node * FindNode(const KK& kval) const
+    {
+      Node * n = Locate(kval);
+      return (n != nullptr && n->IsAlive()) ? n : nullptr;
+    }
+
+    // recursive left-leaning get; a new node takes its key from kval and
+    // its data from args, both forwarded so they can be moved in
+    template < class KK , class... Args >
+    Node * RGet(Node* nptr, KK&& kval, Node*& location, Args&&... args);
+    static Node * Repair (Node* nptr); // rotations and color flip on the way up
+
+    // bodies of the public Get, Put, Emplace, Upsert for either kind of key
+    template < class KK >
+    D&       GetKey     (KK&& k);
+    template < class KK , class DD >
+    void     PutKey     (KK&& k, DD&& d);
+    template < class KK , class... Args >
+    bool     EmplaceKey (KK&& k, Args&&... args);
+    template < class KK , class F >
+    const D& UpsertKey  (KK&& k, F f);
+
+    // linear rehash: RFlatten threads the alive nodes into an ascending list
+    // through rchild_ (releasing dead ones), RBuild relinks n of them into a
+    // minimum height LLRB of black height h
+    Node *        RFlatten  (Node* n, Node* list);
+    static Node * RBuild    (Node*& list, size_t n, int h);
+    static int    BuildHeight (size_t n); // the h that RBuild needs for n nodes
+
+    // stable merge sort of a list of n nodes threaded through rchild_
+    Node *        SortList  (Node* list, size_t n) const;
+
+    // join-based InsertSorted. A tree here is a root, black or nullptr, with
+    // its black height h: the black nodes on every path down to a null link
+    // (0 for an empty tree). Join(l,x,r) needs l < x < r and costs
+    // O(|hl - hr| + 1), and Join2(l,r), with no middle node, uses the least
+    // node of r as one; Split(n,k) costs O(h) and returns the node of k
+    // (alive or dead, detached) or nullptr, leaving the smaller keys in l and
+    // the larger in r. Nodes are relinked, never copied.
+    static int    BlackHeight (const Node* n);
+    static Node * Blacken     (Node* n, int& h); // a red root turns black, one level higher
+    static Node * Join        (Node* l, int hl, Node* x, Node* r, int hr, int& h);
+    static Node * JoinRight   (Node* n, int h, Node* x, Node* r, int hr);
+    static Node * JoinLeft    (Node* l, int hl, Node* x, Node* n, int h);
+    Node *        Join2       (Node* l, int hl, Node* r, int hr, int& h);
+    template < class KK >
+    Node *        Split       (Node* n, int h, const KK& kval, Node*& l, int& hl, Node*& r, int& hr);
+    template < class I , class C >
+    Node *        Union       (Node* n, int h, I first, I last, C c, int& hu);
+
+  }; // class OAA<>
+
+
+  // API
+  /*
+    Returns data (in Wordbench, size_t) associated with the key IN THE TREE.
+    In terms of location: Get declares "location" as a local variable, calls
+    RGet, and then returns "location->data_".
+  */
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  template < class KK >
+  D& OAA<K,D,P,A,M>::GetKey (KK&& k)
+  {
+    Node* location;
+    root_ = RGet(root_, std::forward<KK>(k), location); // RGet() returns a Node pointer
+    root_->SetBlack();  // RGet() returns root_ as red if tree is empty
+    Touch();            // the caller may change the data behind our back
+    return location->data_;  
+  }
+
+  /*
+    Upsert(k,f) applies f to the data of k, inserting (k, DataType()) first if
+    k is not in the table. Most calls in a word count are hits, so the key is
+    looked up with a plain descent first; only a miss takes the recursive
+    insert-and-repair path through RGet. A dead node is revived in place,
+    which changes a flag but not the shape of the tree.
+  */
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  template < class KK , class F >
+  const D& OAA<K,D,P,A,M>::UpsertKey (KK&& k, F f)
+  {
+    Node * n = Locate(k);
+    if (n == nullptr)
+    {
+      root_ = RGet(root_, std::forward<KK>(k), n);
+      root_->SetBlack();
+    }
+    else if (n->IsDead())
+    {
+      n->SetAlive();
+      ++size_;
+    }
+    f(n->data_);
+    Fix(n->key_);
+    return n->data_;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  const D& OAA<K,D,P,A,M>::Increment (const KeyType& k, const DataType& delta)
+  {
+    return UpsertKey(k, [&delta](DataType& d) { d += delta; });
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  const D& OAA<K,D,P,A,M>::Increment (KeyType&& k, const DataType& delta)
+  {
+    return UpsertKey(std::move(k), [&delta](DataType& d) { d += delta; });
+  }
+
+  /*
+    Put and Emplace build the data of a new key straight from their
+    arguments rather than default constructing it first and assigning.
+  */
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  template < class KK , class DD >
+  void OAA<K,D,P,A,M>::PutKey (KK&& k, DD&& d)
+  {
+    Node * n = Locate(k);
+    if (n == nullptr)
+    {
+      root_ = RGet(root_, std::forward<KK>(k), n, std::forward<DD>(d));
+      root_->SetBlack();
+      return;
+    }
+    if (n->IsDead())
+    {
+      n->SetAlive();
+      ++size_;
+    }
+    n->data_ = std::forward<DD>(d);
+    Fix(n->key_);
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  template < class KK , class... Args >
+  bool OAA<K,D,P,A,M>::EmplaceKey (KK&& k, Args&&... args)
+  {
+    Node * n = Locate(k);
+    if (n == nullptr)
+    {
+      root_ = RGet(root_, std::forward<KK>(k), n, std::forward<Args>(args)...);
+      root_->SetBlack();
+      return true;
+    }
+    if (n->IsAlive())
+      return false;
+    n->SetAlive();
+    ++size_;
+    n->data_ = D(std::forward<Args>(args)...);
+    Fix(n->key_);
+    return true;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  template < class KK , class F >
+  void OAA<K,D,P,A,M>::LocateBatch (const KK* keys, size_t n, F finish) const
+  /*
+    Each lane holds one search: the index of its key and the node it is at.
+    A round moves every lane down one level and prefetches the node it lands
+    on, which the lane reads only a round later, after the other lanes have
+    had their turn. A lane whose search ends takes the next key, so the
+    lanes stay busy until the input runs out.
+  */
+  {
+    Node * node[BatchWidth];
+    size_t idx[BatchWidth];
+    size_t next = 0, lanes = 0;
+    for (; lanes < BatchWidth && next < n; ++lanes, ++next)
+    {
+      node[lanes] = root_;
+      idx[lanes] = next;
+    }
+    size_t active = lanes;
+    while (active > 0)
+    {
+      for (size_t g = 0; g < lanes; ++g)
+      {
+        if (idx[g] == n) continue;      // lane retired
+        Node * x = node[g];
+        if (x != nullptr)
+        {
+          int c = Cmp(keys[idx[g]], x->key_);
+          if (c != 0)
+          {
+            x = (c < 0) ? x->lchild_ : x->rchild_;
+            node[g] = x;
+#if defined(__GNUC__)
+            if (x != nullptr) __builtin_prefetch(x);
+#endif
+            continue;
+          }
+        }
+        finish(idx[g], x);
+        if (next < n)
+        {
+          idx[g] = next++;
+          node[g] = root_;
+        }
+        else
+        {
+          idx[g] = n;
+          --active;
+        }
+      }
+    }
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::GetBatch (const KeyType* keys, size_t n, D** out)
+  // hits (and revivals) come from one batched pass; only the misses take
+  // the recursive insert. Nodes never move, so earlier answers stay valid.
+  {
+    size_t misses = 0;
+    LocateBatch(keys, n, [this, out, &misses](size_t i, Node* x)
+    {
+      if (x == nullptr)
+      {
+        out[i] = nullptr;
+        ++misses;
+        return;
+      }
+      if (x->IsDead())
+      {
+        x->SetAlive();
+        ++size_;
+        Fix(x->key_);
+      }
+      out[i] = &x->data_;
+    });
+    for (size_t i = 0; misses > 0 && i < n; ++i)
+    {
+      if (out[i] == nullptr)
+      {
+        out[i] = &GetKey(keys[i]);
+        --misses;
+      }
+    }
+    Touch();
+  }
+
+  /*
+    Find, Contains and Retrieve are the read-only side of the table: a plain
+    descent that neither inserts, revives, nor rebalances, so they work on a
+    const OAA and never write to the nodes they visit.
+  */
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  const D* OAA<K,D,P,A,M>::Find (const KeyType& k) const
+  {
+    const Node * n = FindNode(k);
+    return (n == nullptr) ? nullptr : &n->data_;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  bool OAA<K,D,P,A,M>::Retrieve (const KeyType& k, DataType& d) const
+  {
+    const Node * n = FindNode(k);
+    if (n == nullptr) return false;
+    d = n->data_;
+    return true;
+  }
+
+  // iterators
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::Iterator OAA<K,D,P,A,M>::Begin ()
+  {
+    Touch();
+    Iterator i(root_);
+    i.Next();
+    return i;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::Iterator OAA<K,D,P,A,M>::End ()
+  {
+    return Iterator(root_);
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::Iterator OAA<K,D,P,A,M>::rBegin ()
+  {
+    Touch();
+    Iterator i(root_);
+    i.Prev();
+    return i;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::Iterator OAA<K,D,P,A,M>::rEnd ()
+  {
+    return Iterator(root_);
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::Iterator OAA<K,D,P,A,M>::LowerBound (const KeyType& k)
+  {
+    Touch();
+    Iterator i(root_);
+    Lower(i,k);
+    return i;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::Iterator OAA<K,D,P,A,M>::UpperBound (const KeyType& k)
+  {
+    Touch();
+    Iterator i(root_);
+    Upper(i,k);
+    return i;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  std::pair < typename OAA<K,D,P,A,M>::Iterator , typename OAA<K,D,P,A,M>::Iterator >
+  OAA<K,D,P,A,M>::EqualRange (const KeyType& k)
+  {
+    return std::make_pair(LowerBound(k), UpperBound(k));
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::ConstIterator OAA<K,D,P,A,M>::Begin () const
+  {
+    ConstIterator i(root_);
+    i.Next();
+    return i;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::ConstIterator OAA<K,D,P,A,M>::End () const
+  {
+    return ConstIterator(root_);
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::ConstIterator OAA<K,D,P,A,M>::rBegin () const
+  {
+    ConstIterator i(root_);
+    i.Prev();
+    return i;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::ConstIterator OAA<K,D,P,A,M>::rEnd () const
+  {
+    return ConstIterator(root_);
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::ConstIterator OAA<K,D,P,A,M>::LowerBound (const KeyType& k) const
+  {
+    ConstIterator i(root_);
+    Lower(i,k);
+    return i;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::ConstIterator OAA<K,D,P,A,M>::UpperBound (const KeyType& k) const
+  {
+    ConstIterator i(root_);
+    Upper(i,k);
+    return i;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  std::pair < typename OAA<K,D,P,A,M>::ConstIterator , typename OAA<K,D,P,A,M>::ConstIterator >
+  OAA<K,D,P,A,M>::EqualRange (const KeyType& k) const
+  {
+    return std::make_pair(LowerBound(k), UpperBound(k));
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::Lower (ConstIterator& i, const K& kval) const
+  /*
+    Every node at which the search turns left is a candidate, the last one
+    being the answer. It lies on the search path, so the path down to it is
+    exactly the iterator stack.
+  */
+  {
+    size_t keep = 0;
+    for (Node * n = root_; n != nullptr; )
+    {
+      i.path_.push_back(n);
+      if (pred_(n->key_,kval))
+      {
+        n = n->rchild_;
+      }
+      else
+      {
+        keep = i.path_.size();
+        n = n->lchild_;
+      }
+    }
+    i.path_.resize(keep);
+    if (i.Valid() && i.Current()->IsDead())
+      i.Next();
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::Upper (ConstIterator& i, const K& kval) const
+  {
+    size_t keep = 0;
+    for (Node * n = root_; n != nullptr; )
+    {
+      i.path_.push_back(n);
+      if (pred_(kval,n->key_))
+      {
+        keep = i.path_.size();
+        n = n->lchild_;
+      }
+      else
+      {
+        n = n->rchild_;
+      }
+    }
+    i.path_.resize(keep);
+    if (i.Valid() && i.Current()->IsDead())
+      i.Next();
+  }
+
+  // order statistics
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  size_t OAA<K,D,P,A,M>::Rank (const KeyType& k) const
+  {
+    static_assert(Augmented::value, "OAA::Rank needs the OrderStats<> augmentation");
+    size_t r = 0;
+    for (Node * n = root_; n != nullptr; )
+    {
+      if (pred_(n->key_,k))
+      {
+        r += Count(n->lchild_) + (size_t)n->IsAlive();
+        n = n->rchild_;
+      }
+      else
+      {
+        n = n->lchild_;
+      }
+    }
+    return r;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::ConstIterator OAA<K,D,P,A,M>::Select (size_t i) const
+  {
+    static_assert(Augmented::value, "OAA::Select needs the OrderStats<> augmentation");
+    ConstIterator it(root_);
+    for (Node * n = root_; n != nullptr; )
+    {
+      it.path_.push_back(n);
+      size_t lc = Count(n->lchild_);
+      if (i < lc)
+      {
+        n = n->lchild_;
+      }
+      else if (i == lc && n->IsAlive())
+      {
+        return it;
+      }
+      else
+      {
+        i -= lc + (size_t)n->IsAlive();
+        n = n->rchild_;
+      }
+    }
+    it.path_.clear();
+    return it;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename M::ValueType OAA<K,D,P,A,M>::SumRange (const KeyType& lo, const KeyType& hi) const
+  /*
+    Below the node where the searches for lo and hi part ways, the lo search
+    picks up each right subtree it passes on its left turns, and the hi search
+    each left subtree on its right turns. The monoid need not commute, so
+    everything is combined in key order.
+  */
+  {
+    static_assert(Augmented::value, "OAA::SumRange needs the OrderStats<> augmentation");
+    typedef typename M::MonoidType Mon;
+    Refresh();
+    Node * n = root_;
+    while (n != nullptr)
+    {
+      if (pred_(n->key_,lo))
+        n = n->rchild_;
+      else if (!pred_(n->key_,hi))
+        n = n->lchild_;
+      else
+        break;
+    }
+    if (n == nullptr) return Mon::Identity();
+
+    typename Mon::ValueType left = Mon::Identity(), right = Mon::Identity();
+    for (Node * x = n->lchild_; x != nullptr; )   // keys >= lo
+    {
+      if (pred_(x->key_,lo))
+      {
+        x = x->rchild_;
+      }
+      else
+      {
+        left = Mon::Op(Mon::Op(Self(x), Agg(x->rchild_)), left);
+        x = x->lchild_;
+      }
+    }
+    for (Node * x = n->rchild_; x != nullptr; )   // keys < hi
+    {
+      if (pred_(x->key_,hi))
+      {
+        right = Mon::Op(right, Mon::Op(Agg(x->lchild_), Self(x)));
+        x = x->rchild_;
+      }
+      else
+      {
+        x = x->lchild_;
+      }
+    }
+    return Mon::Op(Mon::Op(left, Self(n)), right);
+  }
+
+  // augmentation upkeep
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::Pull (Node * n, std::true_type)
+  {
+    typedef typename M::MonoidType Mon;
+    n->count_ = (size_t)n->IsAlive() + Count(n->lchild_) + Count(n->rchild_);
+    n->agg_ = Mon::Op(Mon::Op(Agg(n->lchild_), Self(n)), Agg(n->rchild_));
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::RFix (Node * n, const K& kval)
+  // re-pulls the search path of kval bottom up after a change at its end
+  {
+    if (n == nullptr) return;
+    if (pred_(kval,n->key_))
+      RFix(n->lchild_,kval);
+    else if (pred_(n->key_,kval))
+      RFix(n->rchild_,kval);
+    Pull(n);
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::RPullAll (Node * n)
+  {
+    if (n == nullptr) return;
+    RPullAll(n->lchild_);
+    RPullAll(n->rchild_);
+    Pull(n);
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::Refresh () const
+  // data reached through Get, operator[] or an Iterator may have changed
+  {
+    if (stale_)
+    {
+      RPullAll(root_);
+      stale_ = false;
+    }
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::Recount () const
+  // a piece of a Split is not counted until asked, which keeps Split O(log n)
+  {
+    if (!counted_)
+    {
+      size_ = numNodes_ = 0;
+      RTraverse(root_, [this](const Node * n) { ++numNodes_; if (n->IsAlive()) ++size_; });
+      alloc_.SetInUse(numNodes_);
+      counted_ = true;
+    }
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  size_t OAA<K,D,P,A,M>::Count (const Node * n)
+  {
+    return (n == nullptr) ? 0 : n->count_;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename M::ValueType OAA<K,D,P,A,M>::Agg (const Node * n)
+  {
+    return (n == nullptr) ? M::MonoidType::Identity() : n->agg_;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename M::ValueType OAA<K,D,P,A,M>::Self (const Node * n)
+  {
+    return n->IsAlive() ? M::MonoidType::Lift(n->key_, n->data_) : M::MonoidType::Identity();
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::ConstIterator::Next ()
+  {
+    if (path_.empty())
+      Lowest(root_);
+    else
+      Step();
+    while (!path_.empty() && path_.back()->IsDead())
+      Step();
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::ConstIterator::Prev ()
+  {
+    if (path_.empty())
+      Highest(root_);
+    else
+      StepBack();
+    while (!path_.empty() && path_.back()->IsDead())
+      StepBack();
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::ConstIterator::Step ()
+  // successor: leftmost node of the right subtree, or else the nearest
+  // ancestor whose left subtree we are leaving
+  {
+    Node * n = path_.back();
+    if (n->rchild_ != nullptr)
+    {
+      Lowest(n->rchild_);
+      return;
+    }
+    do
+    {
+      n = path_.back();
+      path_.pop_back();
+    }
+    while (!path_.empty() && path_.back()->rchild_ == n);
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::ConstIterator::StepBack ()
+  {
+    Node * n = path_.back();
+    if (n->lchild_ != nullptr)
+    {
+      Highest(n->lchild_);
+      return;
+    }
+    do
+    {
+      n = path_.back();
+      path_.pop_back();
+    }
+    while (!path_.empty() && path_.back()->lchild_ == n);
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::ConstIterator::Lowest (Node * n)
+  {
+    for (; n != nullptr; n = n->lchild_)
+      path_.push_back(n);
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::ConstIterator::Highest (Node * n)
+  {
+    for (; n != nullptr; n = n->rchild_)
+      path_.push_back(n);
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::Erase(const KeyType& k)
+  // marks the node of k dead; the tree is rehashed once rehash_ says so
+  {
+    Node * n = FindNode(k);
+    if (n == nullptr) return;
+    n->SetDead();
+    n->data_ = D();  // a revived key starts over with DataType()
+    --size_;
+    Fix(k);
+    if (rehash_(NumNodes(), NumNodes() - Size()))
+      Rehash();
+  }
+	
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::Clear()
+  /*
+    A slab allocator gives all node storage back in one step, so the tree is
+    only walked when keys or data have destructors to run. Otherwise every
+    node is deleted individually.
+  */
+  {
+    if (alloc_.CanRelease())
+    {
+      RDestroy(root_);
+      alloc_.Release();
+    }
+    else
+    {
+      RRelease(root_);
+    }
+    root_ = nullptr;
+    size_ = numNodes_ = 0;
+    stale_ = false;
+    counted_ = true;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::Rehash()
+  /*
+    Rebuilds the tree in place in O(n): the alive nodes are strung together
+    in order (dead ones go back to alloc_), then relinked as a minimum height
+    LLRB. No node is allocated, copied or compared.
+   */
+  {
+    Recount();
+    Node * list = RFlatten(root_, nullptr);
+    numNodes_ = size_;
+    stale_ = false;   // RBuild pulls every node
+    root_ = RBuild(list, size_, BuildHeight(size_));
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  template < class I , class C >
+  void OAA<K,D,P,A,M>::BulkLoad (I first, I last, C c)
+  /*
+    One pass over the input strings new nodes together in input order. While
+    the keys keep ascending, equal neighbors are folded right away and the
+    list is ready for RBuild, so sorted input costs O(n) with no comparisons
+    beyond one per element. The first descent marks the input unsorted; the
+    rest is appended as it comes, the list is merge sorted (stable, so c
+    still sees duplicates in input order), and duplicates are folded after.
+  */
+  {
+    Clear();
+    Node * head = nullptr, * tail = nullptr;
+    size_t n = 0;
+    bool sorted = true;
+    for (; first != last; ++first)
     {
-     public:
-      PrintNode (std::ostream& os, int kw, int dw,
-                 std::ios_base::fmtflags kf, std::ios_base::fmtflags df )
-        : os_(os), kw_(kw), dw_(dw), kf_(kf), df_(df) {}
-      void operator() (const Node * n) const
+      if (sorted && tail != nullptr && !pred_(tail->key_, first->first))
       {
-        if (n->IsAlive())
+        if (!pred_(first->first, tail->key_)) // equal to the last key
         {
-          os_.setf(kf_,std::ios_base::adjustfield);
-          os_ << std::setw(kw_) << n->key_;
-          os_.setf(df_,std::ios_base::adjustfield);
-          os_ << std::setw(dw_) << n->data_;
-          os_ << '\n';
+          c(tail->data_, first->second);
+          continue;
         }
+        sorted = false;
       }
-     private:
-      std::ostream& os_;
-      int kw_, dw_;      // key and data column widths
-      std::ios_base::fmtflags kf_, df_; // column adjustment flags for output stream
-    }; //class PrintNode
-
-    class CopyNode
+      Node * x = NewNode(first->first, first->second);
+      if (x == nullptr) break;
+      (tail == nullptr ? head : tail->rchild_) = x;
+      tail = x;
+      ++n;
+    }
+    if (!sorted)
     {
-     public:
-      CopyNode (Node*& newroot, OAA<K,D>* oaa) : newroot_(newroot), oldtree_(oaa) {}
-      void operator() (const Node * n) const
+      head = SortList(head, n);
+      for (Node * x = head; x != nullptr && x->rchild_ != nullptr; )
       {
-        if (n->IsAlive())
+        Node * y = x->rchild_;
+        if (pred_(x->key_, y->key_))
         {
-          newroot_ = oldtree_->RInsert(newroot_,n->key_, n->data_);
-          newroot_->SetBlack();
+          x = y;
+        }
+        else
+        {
+          c(x->data_, y->data_);
+          x->rchild_ = y->rchild_;
+          alloc_.Delete(y);
+          --n;
         }
       }
-     private:
-      Node *&    newroot_; 
-      OAA<K,D> * oldtree_;
-    }; //class CopyNode
-    
-  private: // data
-    Node *         root_;
-    PredicateType  pred_;  //Default is LessThan<K>
-
-  private: // methods
-    static Node * NewNode     (const K& k, const D& d, Flags flags = DEFAULT);
-    static void   RRelease    (Node* n); // deletes all descendants of n
-    static Node * RClone      (const Node* n); // returns deep copy of n
-    static size_t RSize       (Node * n);
-    static size_t RNumNodes   (Node * n);
-    static int    RHeight     (Node * n);
-
-    // rotations
-    static Node * RotateLeft  (Node * n);
-    static Node * RotateRight (Node * n);
-
-    template < class F >
-    static void   RTraverse (Node * n, F f);
+    }
+    size_ = numNodes_ = n;
+    stale_ = false;   // RBuild pulls every node
+    root_ = RBuild(head, n, BuildHeight(n));
+  }
 
-    // recursive left-leaning get
-    Node * RGet(Node* nptr, const K& kval, Node*& location);
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  template < class I , class C >
+  void OAA<K,D,P,A,M>::InsertSorted (I first, I last, C c)
+  /*
+    A batch of sorted keys lands in neighboring subtrees, so instead of m
+    descents from root_ the table is split around the batch's middle key,
+    each half takes its half of the batch the same way, and the halves are
+    joined back around the middle node. Splits deep in the recursion work
+    on small trees, which is where O(m log(n/m + 1)) comes from; with m
+    close to n the whole merge is linear.
+  */
+  {
+    if (first == last) return;
+    int h = BlackHeight(root_);
+    root_ = Union(root_, h, first, last, c, h);
+  }
 
-    // recursive left-leaning insert
-    Node * RInsert(Node* nptr, const K& key, const D& data);
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  template < class I , class C >
+  typename OAA<K,D,P,A,M>::Node * OAA<K,D,P,A,M>::Union (Node* n, int h, I first, I last, C c, int& hu)
+  // the tree n, h with the pairs of [first,last) merged in; hu is its height
+  {
+    if (first == last)
+    {
+      hu = h;
+      return n;
+    }
+    typedef typename std::iterator_traits<I>::value_type V;
+    I mid = first;
+    std::advance(mid, std::distance(first, last) / 2);
+    const K& kval = mid->first;
+    I lo = std::lower_bound(first, mid, kval, [this](const V& v, const K& k) { return pred_(v.first, k); });
+    I hi = std::upper_bound(mid, last, kval, [this](const K& k, const V& v) { return pred_(k, v.first); });
+
+    Node * l, * r;
+    int hl, hr;
+    Node * x = Split(n, h, kval, l, hl, r, hr);
+    I i = lo;
+    if (x == nullptr)
+    {
+      x = NewNode(i->first, i->second);
+      if (x == nullptr)   // out of memory: the tree goes back together without this part of the batch
+        return Join2(l, hl, r, hr, hu);
+      ++i;
+      ++size_;
+      ++numNodes_;
+    }
+    else if (x->IsDead())
+    {
+      x->SetAlive();
+      ++size_;
+    }
+    for (; i != hi; ++i)
+      c(x->data_, i->second);
 
-  }; // class OAA<>
+    l = Union(l, hl, first, lo, c, hl);
+    r = Union(r, hr, hi, last, c, hr);
+    return Join(l, hl, x, r, hr, hu);
+  }
 
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  template < class KK >
+  typename OAA<K,D,P,A,M>::Node * OAA<K,D,P,A,M>::Split (Node* n, int h, const KK& kval, Node*& l, int& hl, Node*& r, int& hr)
+  // n's subtrees become trees of their own (a red left child turns black);
+  // n itself rejoins the side of kval it is not on
+  {
+    if (n == nullptr)
+    {
+      l = r = nullptr;
+      hl = hr = 0;
+      return nullptr;
+    }
+    Node * a = n->lchild_, * b = n->rchild_;
+    int ha = h - 1, hb = h - 1;
+    a = Blacken(a, ha);
+    n->lchild_ = n->rchild_ = nullptr;
+    int c = Cmp(kval, n->key_);
+    if (c == 0)
+    {
+      l = a; hl = ha;
+      r = b; hr = hb;
+      return n;
+    }
+    Node * x;
+    if (c < 0)
+    {
+      x = Split(a, ha, kval, l, hl, r, hr);
+      r = Join(r, hr, n, b, hb, hr);
+    }
+    else
+    {
+      x = Split(b, hb, kval, l, hl, r, hr);
+      l = Join(a, ha, n, l, hl, hl);
+    }
+    return x;
+  }
 
-  // API
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  template < class C >
+  void OAA<K,D,P,A,M>::Merge (OAA&& a, C c)
   /*
-    Returns data (in Wordbench, size_t) associated with the key IN THE TREE.
-    In terms of location: Get declares "location" as a local variable, calls
-    RGet, and then returns "location->data_".
+    Both trees are flattened into ascending lists (dead nodes dropped), the
+    lists are merged, one comparison per step, and RBuild relinks the result
+    as in Rehash. a's storage comes along first, so a node left over from a
+    duplicate key is recycled here.
   */
-  template < typename K , typename D , class P >
-  D& OAA<K,D,P>::Get (const KeyType& k)
   {
-    Node* location;
-    root_ = RGet(root_, k, location); // RGet() returns a Node pointer
-    root_->SetBlack();  // RGet() returns root_ as red if tree is empty
-    return location->data_;  
+    if (&a == this) return;
+    Node * x = RFlatten(root_, nullptr);
+    Node * y = a.RFlatten(a.root_, nullptr);
+    alloc_.Absorb(a.alloc_);
+    a.root_ = nullptr;
+    a.size_ = a.numNodes_ = 0;
+    a.stale_ = false;
+    a.counted_ = true;
+
+    Node * head = nullptr, ** tail = &head;
+    size_t n = 0;
+    while (x != nullptr && y != nullptr)
+    {
+      int cmp = Cmp(x->key_, y->key_);
+      if (cmp < 0)
+      {
+        *tail = x;
+        x = x->rchild_;
+      }
+      else if (cmp > 0)
+      {
+        *tail = y;
+        y = y->rchild_;
+      }
+      else
+      {
+        c(x->data_, y->data_);
+        Node * z = y;
+        y = y->rchild_;
+        alloc_.Delete(z);
+        *tail = x;
+        x = x->rchild_;
+      }
+      tail = &(*tail)->rchild_;
+      ++n;
+    }
+    for (*tail = (x != nullptr) ? x : y; *tail != nullptr; tail = &(*tail)->rchild_)
+      ++n;
+
+    size_ = numNodes_ = n;
+    counted_ = true;
+    alloc_.SetInUse(n);
+    stale_ = false;   // RBuild pulls every node
+    root_ = RBuild(head, n, BuildHeight(n));
   }
 
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  std::pair< OAA<K,D,P,A,M> , OAA<K,D,P,A,M> > OAA<K,D,P,A,M>::Split (const KeyType& k)
   /*
-  template < typename K , typename D , class P >
-  void OAA<K,D,P>::Erase(const KeyType& k)
-  {
-    
-    std::cout << "In OAA::Erase()" << std::endl;
-  }
+    The pieces' nodes stay where they are, in this table's slabs, which the
+    two allocators then share. A key-range partition (k goes to the upper
+    piece) can be worked on by one thread per piece and joined back.
   */
-	
-  template < typename K , typename D , class P >
-  void OAA<K,D,P>::Clear()
   {
-    RRelease(root_);
+    OAA lo(pred_), hi(pred_);
+    lo.rehash_ = hi.rehash_ = rehash_;
+    lo.stale_ = hi.stale_ = stale_;
+
+    Node * l, * r;
+    int hl, hr;
+    Node * x = Split(root_, BlackHeight(root_), k, l, hl, r, hr);
+    if (x != nullptr)
+      r = Join(nullptr, 0, x, r, hr, hr);
+    lo.root_ = l;
+    hi.root_ = r;
+    OAA& all = (l == nullptr) ? hi : lo;   // storage and counts go here
+    all.alloc_.Swap(alloc_);
+    all.size_ = size_;
+    all.numNodes_ = numNodes_;
+    all.counted_ = counted_;
+    if (l != nullptr && r != nullptr)
+    {
+      lo.alloc_.Share(hi.alloc_);
+      lo.counted_ = hi.counted_ = false;
+    }
     root_ = nullptr;
-    delete root_;
+    size_ = numNodes_ = 0;
+    stale_ = false;
+    counted_ = true;
+    return std::make_pair(std::move(lo), std::move(hi));
   }
 
-  template < typename K , typename D , class P >
-  void OAA<K,D,P>::Rehash()
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  bool OAA<K,D,P,A,M>::Join (OAA& lo, OAA& hi)
   /*
-    CopyNode constructor makes the following changes: 
-      CopyNode::Node *& newroot_ = newRoot
-      NopyNode::OAA<K,D> * oldtree_ = this
-    NOTE: the address of newRoot is changed in CopyNode.
-    Traverse(cn) inline calls RTraverse(root_,cn)
-   */
-  { // this is complete!
-    Node* newRoot = nullptr;    
-    CopyNode cn(newRoot,this);  
-    Traverse(cn);
+    The least node of hi is split off and becomes the node joining the two
+    trees. Either of lo and hi may be this table.
+  */
+  {
+    if (lo.root_ != nullptr && hi.root_ != nullptr)
+    {
+      Node * a = lo.root_, * b = hi.root_;
+      while (a->rchild_ != nullptr) a = a->rchild_;
+      while (b->lchild_ != nullptr) b = b->lchild_;
+      if (!lo.pred_(a->key_, b->key_))
+      {
+        std::cerr << " ** OAA::Join: a key of lo is not below every key of hi\n";
+        return false;
+      }
+    }
+    OAA a(std::move(lo)), b(std::move(hi));
     Clear();
-    root_ = newRoot;
+    Swap(a);
+    if (b.root_ == nullptr)
+      return true;
+    if (root_ == nullptr)
+    {
+      Swap(b);
+      return true;
+    }
+
+    int h;
+    root_ = Join2(root_, BlackHeight(root_), b.root_, BlackHeight(b.root_), h);
+
+    alloc_.Absorb(b.alloc_);
+    size_ += b.size_;
+    numNodes_ += b.numNodes_;
+    counted_ = counted_ && b.counted_;
+    stale_ = stale_ || b.stale_;
+    b.root_ = nullptr;
+    b.size_ = b.numNodes_ = 0;
+    b.counted_ = true;
+    return true;
   }
 
-  template < typename K , typename D , class P >
-  void  OAA<K,D,P>::Display (std::ostream& os, int kw, int dw, std::ios_base::fmtflags kf, std::ios_base::  fmtflags df) const
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::Node * OAA<K,D,P,A,M>::Join2 (Node* l, int hl, Node* r, int hr, int& h)
+  // every key of l below every key of r; the least node of r is split off to join them
+  {
+    if (r == nullptr)
+    {
+      h = hl;
+      return l;
+    }
+    Node * least = r;
+    while (least->lchild_ != nullptr) least = least->lchild_;
+    Node * a, * b;
+    int ha, hb;
+    Node * x = Split(r, hr, least->key_, a, ha, b, hb);   // a is empty
+    return Join(l, hl, x, b, hb, h);
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::Node * OAA<K,D,P,A,M>::Join (Node* l, int hl, Node* x, Node* r, int hr, int& h)
+  /*
+    x goes into the taller tree, red, in place of the black subtree on its
+    near spine that is as high as the shorter tree, taking that subtree and
+    the shorter tree as children. Black heights still agree, and only the
+    red link to x can be out of place: the same situation as a new red leaf,
+    repaired the same way on the way back up.
+  */
+  {
+    Node * t;
+    if (hl > hr)
+    {
+      t = JoinRight(l, hl, x, r, hr);
+      h = hl;
+    }
+    else if (hl < hr)
+    {
+      t = JoinLeft(l, hl, x, r, hr);
+      h = hr;
+    }
+    else
+    {
+      x->lchild_ = l;
+      x->rchild_ = r;
+      x->SetRed();
+      Pull(x);
+      t = x;
+      h = hl;
+    }
+    return Blacken(t, h);
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::Node * OAA<K,D,P,A,M>::JoinRight (Node* n, int h, Node* x, Node* r, int hr)
+  // right links are never red, so every step down the right spine is one black level
+  {
+    if (h == hr)
+    {
+      x->lchild_ = n;
+      x->rchild_ = r;
+      x->SetRed();
+      Pull(x);
+      return x;
+    }
+    n->rchild_ = JoinRight(n->rchild_, h - 1, x, r, hr);
+    return Repair(n);
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::Node * OAA<K,D,P,A,M>::JoinLeft (Node* l, int hl, Node* x, Node* n, int h)
+  // the left spine may hold red nodes, which are passed over to their black child
+  {
+    if (h == hl && (n == nullptr || n->IsBlack()))
+    {
+      x->lchild_ = l;
+      x->rchild_ = n;
+      x->SetRed();
+      Pull(x);
+      return x;
+    }
+    n->lchild_ = JoinLeft(l, hl, x, n->lchild_, n->IsBlack() ? h - 1 : h);
+    return Repair(n);
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  int OAA<K,D,P,A,M>::BlackHeight (const Node* n)
+  {
+    int h = 0;
+    for (; n != nullptr; n = n->lchild_)
+      if (n->IsBlack()) ++h;
+    return h;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::Node * OAA<K,D,P,A,M>::Blacken (Node* n, int& h)
+  {
+    if (n != nullptr && n->IsRed())
+    {
+      n->SetBlack();
+      ++h;
+    }
+    return n;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void  OAA<K,D,P,A,M>::Display (std::ostream& os, int kw, int dw, std::ios_base::fmtflags kf, std::ios_base::  fmtflags df) const
   // Displays tree as inorder traversal
   {
-    
     PrintNode print(os, kw, dw, kf, df);  // print(node) will only print alive nodes
-    Node * t = this->root_;    // temp is initialized to root
-    Node * A = NewNode(K(),D());          // A is always temp's parent
-    Node * B = NewNode(K(),D());
-    // find the smallest key
-    //int test = 50;
-    // initialize t to the left most node before algorithm
-    A = t;
-    while(t->lchild_ != 0)
-    {
-      std::cout << "going down" << std::endl;
-      A->lchild_->rchild_ = t;
-      t = t->lchild_;
-      A = A->lchild_;
-      print(A);
-      print(t);
-    }
-    /*
-    while(A->rchild_ != 0)
-    {
-      std::cout << "going up" << std::endl;
-      t = A;
-      print(t);
-      A = A->rchild_;
-    }
-    */
-    std::cout << "Inorder traversal" << std::endl;
-    print(t);
-    B = t;  // node already visited is B
-    int test = 50;
-    while (--test != 0)
-    {
-      while(t->lchild_ != 0 && t->lchild_ != B)
-      {
-        std::cout << "going left" << std::endl;
-        A->lchild_->rchild_ = t;
-        t = t->lchild_;
-        A = A->lchild_;
-      }
-
-      if(t->rchild_ == 0 && t->lchild_ == 0 && t == B)
-      {
-        t = A;             // go back to parent
-        A = A->rchild_;
-      }
-      else if(t->rchild_ != 0 && t->lchild_ == B)
-      {
-        //A->rchild_->lchild_ = t;
-        t = t->rchild_;
-      }
-      print(t);
-      B = t;
-      std::cout << "End of while" << std::endl;
-    } // while
-    
-    
+    Traverse(print);
   } // Display
 
-  template < typename K , typename D , class P >
-  typename OAA<K,D,P>::Node * OAA<K,D,P>::RGet(Node* nptr, const K& kval, Node*& location)
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  template < class KK >
+  typename OAA<K,D,P,A,M>::Node * OAA<K,D,P,A,M>::Locate(const KK& kval) const
+  {
+    Node * n = root_;
+    while (n != nullptr)
+    {
+      int c = Cmp(kval,n->key_);
+      if (c < 0)
+        n = n->lchild_;
+      else if (c > 0)
+        n = n->rchild_;
+      else
+        return n;
+    }
+    return nullptr;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  template < class KK , class... Args >
+  typename OAA<K,D,P,A,M>::Node * OAA<K,D,P,A,M>::RGet(Node* nptr, KK&& kval, Node*& location, Args&&... args)
   // recursive left-leaning get
   /*
     RGet() is based on the table semantics:
@@ -349,27 +1802,41 @@ namespace fsu
   {   
     if (nptr == nullptr)    //add new node at bottom of tree
     {
-      location = NewNode(kval,D());  // new node is alive and red
+      location = NewNode(std::forward<KK>(kval), std::forward<Args>(args)...); // alive and red
+      Pull(location);
+      ++size_;
+      ++numNodes_;
       return location;
     }
 
     // inserting recursively
-    if (pred_(kval,nptr->key_))      // go down left branch
+    int c = Cmp(kval,nptr->key_);
+    if (c < 0)       // go down left branch
     {
-      nptr->lchild_ = RGet(nptr->lchild_, kval, location);
+      nptr->lchild_ = RGet(nptr->lchild_, std::forward<KK>(kval), location, std::forward<Args>(args)...);
     }
-    else if (pred_(nptr->key_,kval))  // go down right branch
-		
+    else if (c > 0)  // go down right branch
     {
-      nptr->rchild_ = RGet(nptr->rchild_, kval, location);
+      nptr->rchild_ = RGet(nptr->rchild_, std::forward<KK>(kval), location, std::forward<Args>(args)...);
     }
     else  // if key already exists
     {
-      nptr->SetAlive();  //this revives a dead node
+      if (nptr->IsDead())
+      {
+        nptr->SetAlive();  //this revives a dead node
+        ++size_;
+      }
       location = nptr;
     }
 
-    // repair on the way back up tree
+    return Repair(nptr);  // repair on the way back up tree
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::Node * OAA<K,D,P,A,M>::Repair(Node* nptr)
+  // restores the left-leaning shape below nptr after one of its links has
+  // taken a red node, the LLRB insertion fixup
+  {
     if (nptr->rchild_ != 0 && nptr->rchild_->IsRed() && !(nptr->lchild_ != 0 && nptr->lchild_->IsRed()))
     {
       nptr = RotateLeft(nptr);
@@ -384,79 +1851,206 @@ namespace fsu
       nptr->rchild_->SetBlack();
       nptr->SetRed();
     }
+    Pull(nptr);
     return nptr;
   }
 
-  template < typename K , typename D , class P >
-  typename OAA<K,D,P>::Node * OAA<K,D,P>::RInsert(Node* nptr, const K& key, const D& data)
-  /* 
-     recursive left-leaning insert
-     RInsert, unlike RGet, itself has the ability to change the data of an
-     existing key.
-   */
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::Node * OAA<K,D,P,A,M>::RFlatten(Node* n, Node* list)
+  // reverse in-order walk, so each alive node is pushed in front of its successors
   {
-    //if(nptr != 0)
-      //std::cout << "key: " << nptr->key_ << " data: " << nptr->data_ << std::endl;
-    // else
-      //    std::cout << "NULL" << std::endl;
-    // invariant: number of black nodes in root->null paths has not changed
-    // This means the only place the black node count goes up is at the top:
-    // if the node returned by RInsert is red, its color changes to black in Insert
-    // if a key is not found, then RGet will return a new node with the key
-    // nptr is set alive/ black in RGet()
-    Node* location;
-    nptr = RGet(nptr,key,location);
-    if (nptr->key_ == key)  // node found (and now alive)
+    if (n == nullptr) return list;
+    Node * left = n->lchild_;
+    list = RFlatten(n->rchild_, list);
+    if (n->IsAlive())
+    {
+      n->lchild_ = nullptr;
+      n->rchild_ = list;
+      list = n;
+    }
+    else
+    {
+      alloc_.Delete(n);
+    }
+    return RFlatten(left, list);
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::Node * OAA<K,D,P,A,M>::RBuild(Node*& list, size_t n, int h)
+  /*
+    pre:  2^h - 1 <= n <= 2^(h+1) - 2 (n == 0 iff h == 0)
+    post: the first n nodes of list, taken in order, form an LLRB whose root is
+          black and whose black height is h; list points past them
+
+    A perfect black tree of height h holds 2^h - 1 nodes. Every extra node
+    has to be a red left child (the second key of a 2-3 node). With n at the
+    top of its range, 2^(h+1) - 2, the root takes a red left child whose two
+    subtrees are perfect and black. Otherwise the root is a 2-node and the
+    remaining n-1 nodes are split as evenly as the range allows. Either way
+    every root to null path has h black nodes and at most one red one, so
+    the height is h+1, the least possible for n nodes.
+  */
+  {
+    if (n == 0) return nullptr;
+    size_t full = ((size_t)1 << h) - 1;
+    Node * root;
+    if (n == 2 * full)
+    {
+      size_t half = full / 2;          // 2^(h-1) - 1
+      Node * l = RBuild(list, half, h-1);
+      Node * red = list;
+      list = list->rchild_;
+      red->lchild_ = l;
+      red->rchild_ = RBuild(list, half, h-1);
+      red->SetRed();
+      Pull(red);
+      root = list;
+      list = list->rchild_;
+      root->lchild_ = red;
+      root->rchild_ = RBuild(list, n - full - 1, h-1);
+    }
+    else
+    {
+      size_t nl = n / 2;
+      Node * l = RBuild(list, nl, h-1);
+      root = list;
+      list = list->rchild_;
+      root->lchild_ = l;
+      root->rchild_ = RBuild(list, n - 1 - nl, h-1);
+    }
+    root->SetBlack();
+    Pull(root);
+    return root;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::Node * OAA<K,D,P,A,M>::SortList(Node* list, size_t n) const
+  {
+    if (n < 2)
     {
-      nptr->data_ = data;                // data is changed
+      if (list != nullptr) list->rchild_ = nullptr;
+      return list;
     }
-    else                    // node does not exist
-    {                       // key was added in RGet()
-      nptr->data_ = data;
+    Node * right = list;
+    for (size_t i = 0; i < n/2; ++i)
+      right = right->rchild_;
+    Node * left = SortList(list, n/2);   // cuts the list after n/2 nodes
+    right = SortList(right, n - n/2);
+    Node * head = nullptr, ** tail = &head;
+    while (left != nullptr && right != nullptr)
+    {
+      if (pred_(right->key_, left->key_))
+      {
+        *tail = right;
+        right = right->rchild_;
+      }
+      else                                // ties keep input order
+      {
+        *tail = left;
+        left = left->rchild_;
+      }
+      tail = &(*tail)->rchild_;
     }
-    nptr->SetBlack();
-    return nptr;     
+    *tail = (left != nullptr) ? left : right;
+    return head;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  int OAA<K,D,P,A,M>::BuildHeight(size_t n)
+  // largest h with 2^h - 1 <= n
+  {
+    int h = 0;
+    while (h < 63 && (((size_t)1 << (h+1)) - 1) <= n)
+      ++h;
+    return h;
   }
-         
-         
+
   /* everyting below here is complete */
 
   // proper type
   
-  template < typename K , typename D , class P >
-  OAA<K,D,P>::OAA  () : root_(nullptr), pred_()
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  OAA<K,D,P,A,M>::OAA  () : root_(nullptr), pred_(), size_(0), numNodes_(0), stale_(false),
+                              counted_(true)
   {}
 
-  template < typename K , typename D , class P >
-  OAA<K,D,P>::OAA  (P p) : root_(nullptr), pred_(p)
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  OAA<K,D,P,A,M>::OAA  (P p) : root_(nullptr), pred_(p), size_(0), numNodes_(0), stale_(false),
+                                 counted_(true)
   {}
 
-  template < typename K , typename D , class P >
-  OAA<K,D,P>::~OAA ()
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  template < class I >
+  OAA<K,D,P,A,M>::OAA  (I first, I last, P p) : root_(nullptr), pred_(p), size_(0), numNodes_(0),
+                                                  stale_(false), counted_(true)
+  {
+    BulkLoad(first, last);
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  OAA<K,D,P,A,M>::~OAA ()
   {
     Clear();
   }
 
-  template < typename K , typename D , class P >
-  OAA<K,D,P>::OAA( const OAA& tree ) : root_(nullptr), pred_(tree.pred_)
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  OAA<K,D,P,A,M>::OAA( const OAA& tree ) : root_(nullptr), pred_(tree.pred_),
+                                            size_(tree.Size()), numNodes_(tree.NumNodes()),
+                                            rehash_(tree.rehash_), stale_(false), counted_(true)
   {
     root_ = RClone(tree.root_);
   }
 
-  template < typename K , typename D , class P >
-  OAA<K,D,P>& OAA<K,D,P>::operator=( const OAA& that )
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  OAA<K,D,P,A,M>& OAA<K,D,P,A,M>::operator=( const OAA& that )
   {
     if (this != &that)
     {
       Clear();
       this->root_ = RClone(that.root_);
+      size_ = that.Size();
+      numNodes_ = that.NumNodes();
+      rehash_ = that.rehash_;
+      stale_ = false;      // RClone recomputed the aggregates
+    }
+    return *this;
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  OAA<K,D,P,A,M>::OAA( OAA&& tree ) : root_(nullptr), pred_(tree.pred_), size_(0), numNodes_(0),
+                                       rehash_(tree.rehash_), stale_(false), counted_(true)
+  {
+    Swap(tree);
+  }
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  OAA<K,D,P,A,M>& OAA<K,D,P,A,M>::operator=( OAA&& that )
+  {
+    if (this != &that)
+    {
+      Clear();
+      Swap(that);
     }
     return *this;
   }
 
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::Swap( OAA& that )
+  // exchanges nodes and their storage; O(1)
+  {
+    std::swap(root_, that.root_);
+    std::swap(pred_, that.pred_);
+    alloc_.Swap(that.alloc_);
+    std::swap(size_, that.size_);
+    std::swap(numNodes_, that.numNodes_);
+    std::swap(rehash_, that.rehash_);
+    std::swap(stale_, that.stale_);
+    std::swap(counted_, that.counted_);
+  }
+
   // rotations
-  template < typename K , typename D , class P >
-  typename OAA<K,D,P>::Node * OAA<K,D,P>::RotateLeft(Node * n)
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::Node * OAA<K,D,P,A,M>::RotateLeft(Node * n)
   {
     if (nullptr == n || n->rchild_ == nullptr) return n;
     if (!n->rchild_->IsRed())
@@ -470,11 +2064,13 @@ namespace fsu
 
     n->IsRed()? p->SetRed() : p->SetBlack();
     n->SetRed();
+    Pull(n);
+    Pull(p);
     return p;
   }
 
-  template < typename K , typename D , class P >
-  typename OAA<K,D,P>::Node * OAA<K,D,P>::RotateRight(Node * n)
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::Node * OAA<K,D,P,A,M>::RotateRight(Node * n)
   {
     if (n == nullptr || n->lchild_ == nullptr) return n;
     if (!n->lchild_->IsRed())
@@ -489,27 +2085,15 @@ namespace fsu
 
     n->IsRed()? p->SetRed() : p->SetBlack();
     n->SetRed();
+    Pull(n);
+    Pull(p);
     return p;
   }
 
   // private static recursive methods
 
-  template < typename K , typename D , class P >
-  size_t OAA<K,D,P>::RSize(Node * n)
-  {
-    if (n == nullptr) return 0;
-    return (size_t)(n->IsAlive()) + RSize(n->lchild_) + RSize(n->rchild_);
-  }
-
-  template < typename K , typename D , class P >
-  size_t OAA<K,D,P>::RNumNodes(Node * n)
-  {
-    if (n == nullptr) return 0;
-    return 1 + RNumNodes(n->lchild_) + RNumNodes(n->rchild_);
-  }
-
-  template < typename K , typename D , class P >
-  int OAA<K,D,P>::RHeight(Node * n)
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  int OAA<K,D,P,A,M>::RHeight(Node * n)
   {
     if (n == nullptr) return -1;
     int lh = RHeight(n->lchild_);
@@ -518,36 +2102,13 @@ namespace fsu
     return 1 + lh;
   }
 
-  template < typename K , typename D , class P >
+  template < typename K , typename D , class P , template < typename > class A , class M >
   template < class F >
-  void OAA<K,D,P>::RTraverse (Node * n, F f)
+  void OAA<K,D,P,A,M>::RTraverse (Node * n, F f)
   /*
-    As of 8/5/15:
-    n is always root_.
-    f is of type CopyNode. Member data includes:
-      Node *& newroot_ and OAA<K,D> * oldtree_
-    f(n) represents:
-      void operator() (const Node * n) const
-      {
-        if (n->IsAlive())
-        {
-          newroot_ = oldtree_->RInsert(newroot_,n->key_, n->data_);
-          newroot_->SetBlack();
-        }
-      }
-
-      PROOF (Assume tree root is alive and has left and right children)
-        The first recursive call to RTraverse can be viewed as going all the way 
-      down the left branch of the tree until a nullptr is found. Then f(n) is
-      called starting with the smallest key which should always pass as
-      n->IsAlive() in f(n) if root_ is not null. Then that node is checked to
-      see if it has a right child. IF it does then it travels all the way down to the left
-      (i.e. RTraverse(n->lchild_,f) all over again. ELSE n points to A.
-        Ending condition is when the memory stack is empty of calls to RTraverse
-      (i.e. all nodes have been traversed). All the dead nodes in the old tree
-      were eliminated. Thus, all the nodes now only point to other alive nodes.  
-
-      Traverse, thus RTraverse(root_,n) is called in OAA<K,D,P>::Rehash()
+    In-order: f(n) is applied to every node, dead ones included, smallest key
+    first. The recursion goes all the way down the left branch before the
+    first call to f, then takes each right subtree the same way.
    */
   {
     if (n == nullptr) return;
@@ -556,46 +2117,50 @@ namespace fsu
     RTraverse(n->rchild_,f);
   }
 
-  template < typename K , typename D , class P >
-  void OAA<K,D,P>::RRelease(Node* n)
-  // post:  all descendants of n have been deleted
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::RRelease(Node* n)
+  // post:  n and all descendants of n have been deleted
   {
     if (n != nullptr)
     {
-      if (n->lchild_ != nullptr)
-      {
-        OAA<K,D,P>::RRelease(n->lchild_);
-        delete n->lchild_;
-        n->lchild_ = nullptr;
-      }
-      if (n->rchild_ != nullptr)
-      {
-        OAA<K,D,P>::RRelease(n->rchild_);
-        delete n->rchild_;
-        n->rchild_ = nullptr;
-      }
+      RRelease(n->lchild_);
+      RRelease(n->rchild_);
+      alloc_.Delete(n);
     }
-  } // OAA<K,D,P>::RRelease()
+  } // OAA<K,D,P,A,M>::RRelease()
 
-  template < typename K , typename D , class P >
-  typename OAA<K,D,P>::Node* OAA<K,D,P>::RClone(const OAA<K,D,P>::Node* n)
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::RDestroy(Node* n)
+  // post:  n and its descendants are destroyed but their storage is not returned
+  {
+    if (std::is_trivially_destructible<Node>::value || n == nullptr)
+      return;
+    RDestroy(n->lchild_);
+    RDestroy(n->rchild_);
+    n->~Node();
+  } // OAA<K,D,P,A,M>::RDestroy()
+
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  typename OAA<K,D,P,A,M>::Node* OAA<K,D,P,A,M>::RClone(const OAA<K,D,P,A,M>::Node* n)
   // returns a pointer to a deep copy of n
   {
     if (n == nullptr)
       return 0;
-    typename OAA<K,D,P>::Node* newN = NewNode (n->key_,n->data_);
+    typename OAA<K,D,P,A,M>::Node* newN = NewNode (n->key_,n->data_);
     newN->flags_ = n->flags_;
-    newN->lchild_ = OAA<K,D,P>::RClone(n->lchild_);
-    newN->rchild_ = OAA<K,D,P>::RClone(n->rchild_);
+    newN->lchild_ = OAA<K,D,P,A,M>::RClone(n->lchild_);
+    newN->rchild_ = OAA<K,D,P,A,M>::RClone(n->rchild_);
+    Pull(newN);
     return newN;
-  } // end OAA<K,D,P>::RClone() */
+  } // end OAA<K,D,P,A,M>::RClone() */
 
 
   // private node allocator
-  template < typename K , typename D , class P >
-  typename OAA<K,D,P>::Node * OAA<K,D,P>::NewNode(const K& k, const D& d, Flags flags) 
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  template < class KK , class... Args >
+  typename OAA<K,D,P,A,M>::Node * OAA<K,D,P,A,M>::NewNode(KK&& k, Args&&... args) 
   {
-    Node * nPtr = new(std::nothrow) Node(k,d,flags);
+    Node * nPtr = alloc_.New(std::forward<KK>(k), std::forward<Args>(args)...);
     if (nPtr == nullptr)
     {
       std::cerr << "** OAA memory allocation failure\n";
@@ -606,8 +2171,8 @@ namespace fsu
 
   // development assistants
 
-  template < typename K , typename D , class P >
-  void OAA<K,D,P>::DumpBW (std::ostream& os) const
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::DumpBW (std::ostream& os) const
   {
     // fsu::debug ("DumpBW(1)");
     // This is the same as "Dump(1)" except it uses a character map instead of a
@@ -694,8 +2259,8 @@ namespace fsu
     Que.Clear();
   } // DumpBW(os)
 
-  template < typename K , typename D , class P >
-  void OAA<K,D,P>::Dump (std::ostream& os) const
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::Dump (std::ostream& os) const
   {
     // fsu::debug ("Dump(1)");
 
@@ -786,8 +2351,8 @@ namespace fsu
     Que.Clear();
   } // Dump(os)
 
-  template < typename K , typename D , class P >
-  void OAA<K,D,P>::Dump (std::ostream& os, int kw) const
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::Dump (std::ostream& os, int kw) const
   {
     // fsu::debug ("Dump(2)");
     if (root_ == nullptr)
@@ -822,17 +2387,18 @@ namespace fsu
       currLayerSize = nextLayerSize;
     } // end while
     if (currLayerSize > 0)
-      std::cerr << "** OAA<K,D,P>::Dump() inconsistency\n";
+      std::cerr << "** OAA<K,D,P,A,M>::Dump() inconsistency\n";
   } // Dump(os, kw)
 
-  template < typename K , typename D , class P >
-  void OAA<K,D,P>::Dump (std::ostream& os, int kw, char fill) const
+  template < typename K , typename D , class P , template < typename > class A , class M >
+  void OAA<K,D,P,A,M>::Dump (std::ostream& os, int kw, char fill) const
   {
     // fsu::debug ("Dump(3)");
     if (root_ == nullptr)
       return;
 
-    Node* fillNode = NewNode(K(),D());
+    Node fillNode_((K()),(D()));   // placeholder, detected by address
+    Node* fillNode = &fillNode_;
     Queue < Node * , Deque < Node * > > Que;
     Node * current;
     size_t currLayerSize, nextLayerSize, j, k;
@@ -881,7 +2447,6 @@ namespace fsu
       k *= 2;
     } // end while
     Que.Clear();
-    delete fillNode;
   } // Dump(os, kw, fill) */
 
 } // namespace fsu 
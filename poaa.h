@@ -0,0 +1,779 @@
+/*
+    poaa.h
+    10/16/26
+
+    PersistentOAA: the left-leaning red-black table of oaa.h with copies that
+    share structure.
+
+    Sharing
+    -------
+    Copying an OAA clones every node. A PersistentOAA copy (copy
+    constructor, assignment, Snapshot()) takes one more reference to the
+    root instead, in O(1). Every node counts the tables and parent nodes
+    pointing at it. A change walks down the search path and clones each node
+    still shared with another table before writing to it ("path copying"),
+    so it copies at most the O(log n) nodes it touches (and a sibling of one
+    when a color flip reaches it). Once a path is owned by one table alone,
+    later changes along it write in place, as OAA does. Nodes no longer
+    reachable from any table are freed by the last one to let go.
+
+    Threads
+    -------
+    Reference counts are atomic, and a node is written only while exactly
+    one table can reach it, so a copy handed to another thread is a
+    consistent view that can be read and destroyed there while the original
+    goes on changing. A single table is no safer than an OAA: only one thread
+    at a time may change it.
+
+    Interface
+    ---------
+    Get, operator[], Put, Upsert, Increment, Find, Contains, Retrieve (also
+    heterogeneous with a transparent P), Erase (a tombstone, compacted by
+    the DeadRatio policy), Clear, Rehash, Size, NumNodes, Height, Display,
+    ConstIterator with Begin/End/rBegin/rEnd/LowerBound/UpperBound. There is
+    no mutable Iterator. A reference from Get or operator[] may be written
+    until the table is next copied or changed. Rehash builds fresh nodes for
+    the alive entries, in O(n), leaving older copies untouched. Nodes come
+    from new and delete, since they outlive the table that made them.
+*/
+
+#ifndef _POAA_H
+#define _POAA_H
+
+#include <cstddef>    // size_t
+#include <atomic>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <oaa.h>      // LessThan, DeadRatio, IsTransparent, IsThreeWay
+
+namespace fsu
+{
+
+  template < typename K , typename D , class P = LessThan<K> >
+  class PersistentOAA
+  {
+  public:
+    typedef K  KeyType;
+    typedef D  DataType;
+    typedef P  PredicateType;
+
+             PersistentOAA  ();
+    explicit PersistentOAA  (P p);
+             PersistentOAA  (const PersistentOAA& a);  // O(1), shares a's nodes
+             PersistentOAA  (PersistentOAA&& a);
+             ~PersistentOAA ();
+    PersistentOAA& operator=(const PersistentOAA& a);  // O(1)
+    PersistentOAA& operator=(PersistentOAA&& a);
+    void Swap               (PersistentOAA& a);
+
+    // a copy that later changes to this table do not show through
+    PersistentOAA Snapshot () const { return *this; }
+
+    DataType& operator [] (const KeyType& k)        { return Get(k); }
+
+    void Put (const KeyType& k , const DataType& d);
+    D&   Get (const KeyType& k)                     { return Access(k)->data_; }
+
+    template <class F>  //F is applied to the data of k
+    const D& Upsert    (const KeyType& k, F f)      { return UpsertKey(k, f); }
+    const D& Increment (const KeyType& k, const DataType& delta = DataType(1))
+    {
+      return UpsertKey(k, [&delta](DataType& d) { d += delta; });
+    }
+
+    const D* Find     (const KeyType& k) const { return FindData(k); }
+    bool     Contains (const KeyType& k) const { return FindNode(k) != nullptr; }
+    bool     Retrieve (const KeyType& k, DataType& d) const { return RetrieveKey(k, d); }
+
+    // heterogeneous lookup, as in OAA
+    template < class KK >
+    using IfTransparent = typename std::enable_if<IsTransparent<P>::value, KK>::type;
+
+    template < class KK , class = IfTransparent<KK> >
+    DataType& operator [] (const KK& k)         { return Access(k)->data_; }
+    template < class KK , class = IfTransparent<KK> >
+    D&       Get       (const KK& k)            { return Access(k)->data_; }
+    template < class KK , class F , class = IfTransparent<KK> >
+    const D& Upsert    (const KK& k, F f)       { return UpsertKey(k, f); }
+    template < class KK , class = IfTransparent<KK> >
+    const D& Increment (const KK& k, const DataType& delta = DataType(1))
+    {
+      return UpsertKey(k, [&delta](DataType& d) { d += delta; });
+    }
+    template < class KK , class = IfTransparent<KK> >
+    const D* Find      (const KK& k) const      { return FindData(k); }
+    template < class KK , class = IfTransparent<KK> >
+    bool     Contains  (const KK& k) const      { return FindNode(k) != nullptr; }
+    template < class KK , class = IfTransparent<KK> >
+    bool     Retrieve  (const KK& k, DataType& d) const { return RetrieveKey(k, d); }
+
+    void Erase  (const KeyType& k);
+    void Clear  ();
+    void Rehash ();
+
+    void             SetRehashPolicy (const DeadRatio& r) { rehash_ = r; }
+    const DeadRatio& RehashPolicy    () const             { return rehash_; }
+
+    bool   Empty    () const { return size_ == 0; }
+    size_t Size     () const { return size_; }      // counts alive nodes
+    size_t NumNodes () const { return numNodes_; }  // counts nodes
+    int    Height   () const { return RHeight(root_); }
+
+    class ConstIterator;
+
+    ConstIterator Begin      () const;
+    ConstIterator End        () const { return ConstIterator(root_); }
+    ConstIterator rBegin     () const;
+    ConstIterator rEnd       () const { return ConstIterator(root_); }
+    ConstIterator LowerBound (const KeyType& k) const;
+    ConstIterator UpperBound (const KeyType& k) const;
+
+    void   Display (std::ostream& os, int kw, int dw,     // key, data widths
+                    std::ios_base::fmtflags kf = std::ios_base::right, // key flag
+                    std::ios_base::fmtflags df = std::ios_base::right // data flag
+                   ) const;
+
+  private:
+    enum Flags { ZERO = 0x00 , DEAD = 0x01, RED = 0x02 , DEFAULT = RED };
+
+    class Node
+    {
+      const KeyType        key_;
+            DataType       data_;
+      Node * lchild_, * rchild_;
+      unsigned char        flags_;
+      std::atomic<size_t>  refs_;   // tables and parents pointing here
+
+      template < class KK , class... Args >  // data_ is built from args
+      explicit Node (KK&& k, Args&&... args)
+        : key_(std::forward<KK>(k)), data_(std::forward<Args>(args)...),
+          lchild_(nullptr), rchild_(nullptr), flags_(DEFAULT), refs_(1)
+      {}
+      friend class PersistentOAA<K,D,P>;
+      bool IsRed    () const { return 0 != (RED & flags_); }
+      bool IsBlack  () const { return !IsRed(); }
+      bool IsDead   () const { return 0 != (DEAD & flags_); }
+      bool IsAlive  () const { return !IsDead(); }
+      void SetRed   ()       { flags_ |= RED; }
+      void SetBlack ()       { flags_ &= ~RED; }
+      void SetDead  ()       { flags_ |= DEAD; }
+      void SetAlive ()       { flags_ &= ~DEAD; }
+    }; // class Node
+
+  public: // iterators
+
+    class ConstIterator
+    {
+    public:
+      ConstIterator () : path_(), root_(nullptr) {}
+
+      const KeyType&  Key   () const { return path_.back()->key_; }
+      const DataType& Data  () const { return path_.back()->data_; }
+      bool            Valid () const { return !path_.empty(); }
+
+      ConstIterator& operator ++ ()    { Next(); return *this; }
+      ConstIterator  operator ++ (int) { ConstIterator i(*this); Next(); return i; }
+      ConstIterator& operator -- ()    { Prev(); return *this; }
+      ConstIterator  operator -- (int) { ConstIterator i(*this); Prev(); return i; }
+
+      bool operator == (const ConstIterator& i) const { return Current() == i.Current(); }
+      bool operator != (const ConstIterator& i) const { return Current() != i.Current(); }
+
+    private:
+      friend class PersistentOAA<K,D,P>;
+      explicit ConstIterator (const Node * root) : path_(), root_(root) {}
+
+      const Node * Current () const { return path_.empty() ? nullptr : path_.back(); }
+      void   Next     (); // to the next alive node
+      void   Prev     (); // to the previous alive node
+      void   Step     (); // to the next node, dead or alive
+      void   StepBack (); // to the previous node, dead or alive
+      void   Lowest   (const Node * n);  // push the left spine of n
+      void   Highest  (const Node * n);  // push the right spine of n
+
+      std::vector<const Node*> path_;  // root .. current node; empty at End
+      const Node *             root_;
+    }; // class ConstIterator
+
+  private: // data
+    Node *         root_;
+    PredicateType  pred_;
+    size_t         size_;     // alive nodes
+    size_t         numNodes_; // alive + dead nodes
+    DeadRatio      rehash_;   // when Erase compacts the tree
+
+  private: // methods
+    typedef std::integral_constant < bool , IsThreeWay<P,K>::value > ThreeWayPredicate;
+    template < class KK >
+    int Cmp (const KK& a, const K& b) const { return Cmp(a, b, ThreeWayPredicate()); }
+    template < class KK >
+    int Cmp (const KK& a, const K& b, std::true_type) const { return pred_.Compare(a,b); }
+    template < class KK >
+    int Cmp (const KK& a, const K& b, std::false_type) const
+    {
+      return pred_(a,b) ? -1 : (pred_(b,a) ? 1 : 0);
+    }
+
+    // sharing: Hold takes a reference, Drop gives one back (freeing what no
+    // one reaches any more), Own makes link point to a node only this table
+    // reaches, cloning the shared one it pointed to
+    static Node * Hold (Node * n);
+    static void   Drop (Node * n);
+    static Node * Own  (Node *& link);
+    static Node * Clone (const Node * n);  // shares n's children
+
+    // the node of k, on a path this table alone reaches; a new node takes
+    // its data from args, a dead one is revived
+    template < class KK , class... Args >
+    Node *   Access    (KK&& k, Args&&... args);
+    template < class KK >
+    Node *   OwnPath   (const KK& kval);  // nullptr if k is not in the tree
+    template < class KK , class F >
+    const D& UpsertKey (KK&& k, F f)
+    {
+      Node * n = Access(std::forward<KK>(k));
+      f(n->data_);
+      return n->data_;
+    }
+
+    // recursive left-leaning get, as OAA::RGet, owning each node it passes
+    template < class KK , class... Args >
+    void          RGet        (Node*& link, KK&& kval, Node*& location, Args&&... args);
+    static Node * Repair      (Node * n);
+    static Node * RotateLeft  (Node * n);
+    static Node * RotateRight (Node * n);
+    static bool   IsRed       (const Node * n) { return n != nullptr && n->IsRed(); }
+    static int    RHeight     (const Node * n);
+
+    template < class KK >
+    Node * Locate   (const KK& kval) const;
+    template < class KK >
+    Node * FindNode (const KK& kval) const
+    {
+      Node * n = Locate(kval);
+      return (n != nullptr && n->IsAlive()) ? n : nullptr;
+    }
+    template < class KK >
+    const D* FindData (const KK& k) const
+    {
+      Node * n = FindNode(k);
+      return (n == nullptr) ? nullptr : &n->data_;
+    }
+    template < class KK >
+    bool RetrieveKey (const KK& k, DataType& d) const
+    {
+      Node * n = FindNode(k);
+      if (n == nullptr) return false;
+      d = n->data_;
+      return true;
+    }
+
+    // Rehash: fresh nodes for v[0 .. n) (in order) as a minimum height LLRB
+    // of black height h, the shape OAA::RBuild makes
+    static Node * Build       (const Node * const *& v, size_t n, int h);
+    static int    BuildHeight (size_t n);
+  }; // class PersistentOAA<>
+
+  // proper type
+
+  template < typename K , typename D , class P >
+  PersistentOAA<K,D,P>::PersistentOAA () : root_(nullptr), pred_(), size_(0), numNodes_(0)
+  {}
+
+  template < typename K , typename D , class P >
+  PersistentOAA<K,D,P>::PersistentOAA (P p) : root_(nullptr), pred_(p), size_(0), numNodes_(0)
+  {}
+
+  template < typename K , typename D , class P >
+  PersistentOAA<K,D,P>::PersistentOAA (const PersistentOAA& a)
+    : root_(Hold(a.root_)), pred_(a.pred_), size_(a.size_), numNodes_(a.numNodes_), rehash_(a.rehash_)
+  {}
+
+  template < typename K , typename D , class P >
+  PersistentOAA<K,D,P>::PersistentOAA (PersistentOAA&& a)
+    : root_(nullptr), pred_(a.pred_), size_(0), numNodes_(0), rehash_(a.rehash_)
+  {
+    Swap(a);
+  }
+
+  template < typename K , typename D , class P >
+  PersistentOAA<K,D,P>::~PersistentOAA ()
+  {
+    Drop(root_);
+  }
+
+  template < typename K , typename D , class P >
+  PersistentOAA<K,D,P>& PersistentOAA<K,D,P>::operator= (const PersistentOAA& a)
+  {
+    if (this != &a)
+    {
+      Node * old = root_;
+      root_ = Hold(a.root_);  // before the Drop, in case a is a copy of this
+      Drop(old);
+      pred_ = a.pred_;
+      size_ = a.size_;
+      numNodes_ = a.numNodes_;
+      rehash_ = a.rehash_;
+    }
+    return *this;
+  }
+
+  template < typename K , typename D , class P >
+  PersistentOAA<K,D,P>& PersistentOAA<K,D,P>::operator= (PersistentOAA&& a)
+  {
+    if (this != &a)
+    {
+      Clear();
+      Swap(a);
+    }
+    return *this;
+  }
+
+  template < typename K , typename D , class P >
+  void PersistentOAA<K,D,P>::Swap (PersistentOAA& a)
+  {
+    std::swap(root_, a.root_);
+    std::swap(pred_, a.pred_);
+    std::swap(size_, a.size_);
+    std::swap(numNodes_, a.numNodes_);
+    std::swap(rehash_, a.rehash_);
+  }
+
+  // sharing
+
+  template < typename K , typename D , class P >
+  typename PersistentOAA<K,D,P>::Node * PersistentOAA<K,D,P>::Hold (Node * n)
+  {
+    if (n != nullptr)
+      n->refs_.fetch_add(1, std::memory_order_relaxed);
+    return n;
+  }
+
+  template < typename K , typename D , class P >
+  void PersistentOAA<K,D,P>::Drop (Node * n)
+  // recursion on the left, a loop on the right
+  {
+    while (n != nullptr && n->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      Drop(n->lchild_);
+      Node * r = n->rchild_;
+      delete n;
+      n = r;
+    }
+  }
+
+  template < typename K , typename D , class P >
+  typename PersistentOAA<K,D,P>::Node * PersistentOAA<K,D,P>::Clone (const Node * n)
+  {
+    Node * c = new Node(n->key_, n->data_);
+    c->lchild_ = Hold(n->lchild_);
+    c->rchild_ = Hold(n->rchild_);
+    c->flags_ = n->flags_;
+    return c;
+  }
+
+  template < typename K , typename D , class P >
+  typename PersistentOAA<K,D,P>::Node * PersistentOAA<K,D,P>::Own (Node *& link)
+  /*
+    Called only with links in nodes this table owns (or root_), so a count
+    of 1 means this link is the only way to the node. Otherwise the clone
+    takes this link's reference over from the original.
+  */
+  {
+    Node * n = link;
+    if (n != nullptr && n->refs_.load(std::memory_order_acquire) != 1)
+    {
+      link = Clone(n);
+      Drop(n);
+    }
+    return link;
+  }
+
+  // API
+
+  template < typename K , typename D , class P >
+  template < class KK , class... Args >
+  typename PersistentOAA<K,D,P>::Node * PersistentOAA<K,D,P>::Access (KK&& k, Args&&... args)
+  /*
+    A hit owns its search path with one plain descent; only a miss takes
+    the recursive insert-and-repair path through RGet.
+  */
+  {
+    Node * n = OwnPath(k);
+    if (n == nullptr)
+    {
+      RGet(root_, std::forward<KK>(k), n, std::forward<Args>(args)...);
+      root_->SetBlack();
+    }
+    else if (n->IsDead())
+    {
+      n->SetAlive();
+      ++size_;
+    }
+    return n;
+  }
+
+  template < typename K , typename D , class P >
+  template < class KK >
+  typename PersistentOAA<K,D,P>::Node * PersistentOAA<K,D,P>::OwnPath (const KK& kval)
+  {
+    if (Locate(kval) == nullptr) return nullptr;  // a miss copies nothing here
+    Node ** link = &root_;
+    while (*link != nullptr)
+    {
+      Node * n = Own(*link);
+      int c = Cmp(kval,n->key_);
+      if (c < 0)
+        link = &n->lchild_;
+      else if (c > 0)
+        link = &n->rchild_;
+      else
+        return n;
+    }
+    return nullptr;
+  }
+
+  template < typename K , typename D , class P >
+  void PersistentOAA<K,D,P>::Put (const KeyType& k, const DataType& d)
+  {
+    size_t before = numNodes_;
+    Node * n = Access(k, d);
+    if (numNodes_ == before)  // not a new node
+      n->data_ = d;
+  }
+
+  template < typename K , typename D , class P >
+  void PersistentOAA<K,D,P>::Erase (const KeyType& k)
+  // marks the node of k dead; the tree is rehashed once rehash_ says so
+  {
+    if (FindNode(k) == nullptr) return;
+    Node * n = OwnPath(k);
+    n->SetDead();
+    n->data_ = D();  // a revived key starts over with DataType()
+    --size_;
+    if (rehash_(numNodes_, numNodes_ - size_))
+      Rehash();
+  }
+
+  template < typename K , typename D , class P >
+  void PersistentOAA<K,D,P>::Clear ()
+  // the nodes go only if no copy still reaches them
+  {
+    Drop(root_);
+    root_ = nullptr;
+    size_ = numNodes_ = 0;
+  }
+
+  template < typename K , typename D , class P >
+  void PersistentOAA<K,D,P>::Rehash ()
+  /*
+    The alive entries get new nodes in a minimum height tree; the old nodes
+    may be shared with copies, so they are let go rather than relinked as
+    OAA::Rehash does.
+  */
+  {
+    std::vector<const Node*> v;
+    v.reserve(size_);
+    for (ConstIterator i = Begin(); i != End(); ++i)
+      v.push_back(i.Current());
+    const Node * const * p = v.empty() ? nullptr : &v[0];
+    Node * root = Build(p, v.size(), BuildHeight(v.size()));
+    Drop(root_);
+    root_ = root;
+    numNodes_ = size_;
+  }
+
+  template < typename K , typename D , class P >
+  typename PersistentOAA<K,D,P>::ConstIterator PersistentOAA<K,D,P>::Begin () const
+  {
+    ConstIterator i(root_);
+    i.Next();
+    return i;
+  }
+
+  template < typename K , typename D , class P >
+  typename PersistentOAA<K,D,P>::ConstIterator PersistentOAA<K,D,P>::rBegin () const
+  {
+    ConstIterator i(root_);
+    i.Prev();
+    return i;
+  }
+
+  template < typename K , typename D , class P >
+  typename PersistentOAA<K,D,P>::ConstIterator PersistentOAA<K,D,P>::LowerBound (const KeyType& k) const
+  // the last node at which the search turns left, as in OAA
+  {
+    ConstIterator i(root_);
+    size_t keep = 0;
+    for (const Node * n = root_; n != nullptr; )
+    {
+      i.path_.push_back(n);
+      if (pred_(n->key_,k))
+      {
+        n = n->rchild_;
+      }
+      else
+      {
+        keep = i.path_.size();
+        n = n->lchild_;
+      }
+    }
+    i.path_.resize(keep);
+    if (i.Valid() && i.Current()->IsDead())
+      i.Next();
+    return i;
+  }
+
+  template < typename K , typename D , class P >
+  typename PersistentOAA<K,D,P>::ConstIterator PersistentOAA<K,D,P>::UpperBound (const KeyType& k) const
+  {
+    ConstIterator i(root_);
+    size_t keep = 0;
+    for (const Node * n = root_; n != nullptr; )
+    {
+      i.path_.push_back(n);
+      if (pred_(k,n->key_))
+      {
+        keep = i.path_.size();
+        n = n->lchild_;
+      }
+      else
+      {
+        n = n->rchild_;
+      }
+    }
+    i.path_.resize(keep);
+    if (i.Valid() && i.Current()->IsDead())
+      i.Next();
+    return i;
+  }
+
+  template < typename K , typename D , class P >
+  void PersistentOAA<K,D,P>::Display (std::ostream& os, int kw, int dw, std::ios_base::fmtflags kf, std::ios_base::fmtflags df) const
+  {
+    for (ConstIterator i = Begin(); i != End(); ++i)
+    {
+      os.setf(kf,std::ios_base::adjustfield);
+      os << std::setw(kw) << i.Key();
+      os.setf(df,std::ios_base::adjustfield);
+      os << std::setw(dw) << i.Data();
+      os << '\n';
+    }
+  }
+
+  // iterator steps, as in OAA
+
+  template < typename K , typename D , class P >
+  void PersistentOAA<K,D,P>::ConstIterator::Next ()
+  {
+    if (path_.empty())
+      Lowest(root_);
+    else
+      Step();
+    while (!path_.empty() && path_.back()->IsDead())
+      Step();
+  }
+
+  template < typename K , typename D , class P >
+  void PersistentOAA<K,D,P>::ConstIterator::Prev ()
+  {
+    if (path_.empty())
+      Highest(root_);
+    else
+      StepBack();
+    while (!path_.empty() && path_.back()->IsDead())
+      StepBack();
+  }
+
+  template < typename K , typename D , class P >
+  void PersistentOAA<K,D,P>::ConstIterator::Step ()
+  {
+    const Node * n = path_.back();
+    if (n->rchild_ != nullptr)
+    {
+      Lowest(n->rchild_);
+      return;
+    }
+    do
+    {
+      n = path_.back();
+      path_.pop_back();
+    }
+    while (!path_.empty() && path_.back()->rchild_ == n);
+  }
+
+  template < typename K , typename D , class P >
+  void PersistentOAA<K,D,P>::ConstIterator::StepBack ()
+  {
+    const Node * n = path_.back();
+    if (n->lchild_ != nullptr)
+    {
+      Highest(n->lchild_);
+      return;
+    }
+    do
+    {
+      n = path_.back();
+      path_.pop_back();
+    }
+    while (!path_.empty() && path_.back()->lchild_ == n);
+  }
+
+  template < typename K , typename D , class P >
+  void PersistentOAA<K,D,P>::ConstIterator::Lowest (const Node * n)
+  {
+    for (; n != nullptr; n = n->lchild_)
+      path_.push_back(n);
+  }
+
+  template < typename K , typename D , class P >
+  void PersistentOAA<K,D,P>::ConstIterator::Highest (const Node * n)
+  {
+    for (; n != nullptr; n = n->rchild_)
+      path_.push_back(n);
+  }
+
+  // private methods
+
+  template < typename K , typename D , class P >
+  template < class KK >
+  typename PersistentOAA<K,D,P>::Node * PersistentOAA<K,D,P>::Locate (const KK& kval) const
+  {
+    Node * n = root_;
+    while (n != nullptr)
+    {
+      int c = Cmp(kval,n->key_);
+      if (c < 0)
+        n = n->lchild_;
+      else if (c > 0)
+        n = n->rchild_;
+      else
+        return n;
+    }
+    return nullptr;
+  }
+
+  template < typename K , typename D , class P >
+  template < class KK , class... Args >
+  void PersistentOAA<K,D,P>::RGet (Node*& link, KK&& kval, Node*& location, Args&&... args)
+  {
+    if (link == nullptr)    // add new node at bottom of tree
+    {
+      link = location = new Node(std::forward<KK>(kval), std::forward<Args>(args)...);
+      ++size_;
+      ++numNodes_;
+      return;
+    }
+    Node * n = Own(link);
+    int c = Cmp(kval,n->key_);
+    if (c < 0)
+      RGet(n->lchild_, std::forward<KK>(kval), location, std::forward<Args>(args)...);
+    else if (c > 0)
+      RGet(n->rchild_, std::forward<KK>(kval), location, std::forward<Args>(args)...);
+    else
+      location = n;   // not reached from Access, which finds keys first
+    link = Repair(n);
+  }
+
+  template < typename K , typename D , class P >
+  typename PersistentOAA<K,D,P>::Node * PersistentOAA<K,D,P>::Repair (Node * n)
+  // OAA::Repair; a sibling off the search path is owned before its color flips
+  {
+    if (IsRed(n->rchild_) && !IsRed(n->lchild_))
+    {
+      n = RotateLeft(n);
+    }
+    if (IsRed(n->lchild_) && IsRed(n->lchild_->lchild_))
+    {
+      n = RotateRight(n);
+    }
+    if (IsRed(n->lchild_) && IsRed(n->rchild_))
+    {
+      Own(n->lchild_)->SetBlack();
+      Own(n->rchild_)->SetBlack();
+      n->SetRed();
+    }
+    return n;
+  }
+
+  template < typename K , typename D , class P >
+  typename PersistentOAA<K,D,P>::Node * PersistentOAA<K,D,P>::RotateLeft (Node * n)
+  // n is owned; the child rising in its place is made so
+  {
+    Node * p = Own(n->rchild_);
+    n->rchild_ = p->lchild_;
+    p->lchild_ = n;
+    n->IsRed()? p->SetRed() : p->SetBlack();
+    n->SetRed();
+    return p;
+  }
+
+  template < typename K , typename D , class P >
+  typename PersistentOAA<K,D,P>::Node * PersistentOAA<K,D,P>::RotateRight (Node * n)
+  {
+    Node * p = Own(n->lchild_);
+    n->lchild_ = p->rchild_;
+    p->rchild_ = n;
+    n->IsRed()? p->SetRed() : p->SetBlack();
+    n->SetRed();
+    return p;
+  }
+
+  template < typename K , typename D , class P >
+  int PersistentOAA<K,D,P>::RHeight (const Node * n)
+  {
+    if (n == nullptr) return -1;
+    int lh = RHeight(n->lchild_);
+    int rh = RHeight(n->rchild_);
+    return 1 + ((lh < rh) ? rh : lh);
+  }
+
+  template < typename K , typename D , class P >
+  typename PersistentOAA<K,D,P>::Node * PersistentOAA<K,D,P>::Build (const Node * const *& v, size_t n, int h)
+  // pre: 2^h - 1 <= n <= 2^(h+1) - 2 (n == 0 iff h == 0); see OAA::RBuild
+  {
+    if (n == 0) return nullptr;
+    size_t full = ((size_t)1 << h) - 1;
+    Node * root;
+    if (n == 2 * full)
+    {
+      size_t half = full / 2;
+      Node * l = Build(v, half, h-1);
+      Node * red = new Node((*v)->key_, (*v)->data_);
+      ++v;
+      red->lchild_ = l;
+      red->rchild_ = Build(v, half, h-1);
+      root = new Node((*v)->key_, (*v)->data_);
+      ++v;
+      root->lchild_ = red;   // new nodes are red
+      root->rchild_ = Build(v, n - full - 1, h-1);
+    }
+    else
+    {
+      size_t nl = n / 2;
+      Node * l = Build(v, nl, h-1);
+      root = new Node((*v)->key_, (*v)->data_);
+      ++v;
+      root->lchild_ = l;
+      root->rchild_ = Build(v, n - 1 - nl, h-1);
+    }
+    root->SetBlack();
+    return root;
+  }
+
+  template < typename K , typename D , class P >
+  int PersistentOAA<K,D,P>::BuildHeight (size_t n)
+  // largest h with 2^h - 1 <= n
+  {
+    int h = 0;
+    while (h < 63 && (((size_t)1 << (h+1)) - 1) <= n)
+      ++h;
+    return h;
+  }
+
+} // namespace fsu
+
+#endif
@@ -0,0 +1,404 @@
+/*
+    shardedoaa.h
+    10/16/26
+
+    ShardedOAA: an ordered table that several threads may change at once,
+    made of N OAA shards over consecutive key ranges.
+
+    Layout
+    ------
+    N-1 split points b[0] < b[1] < ... cut the keys into ranges: shard i
+    holds the keys k with b[i-1] <= k < b[i]. Every shard is an
+    OAA<K,D,P> with its own mutex, so callers working on different ranges
+    do not wait for each other. The split points come from a sample of keys
+    given to the constructor, or (with no sample) from the table itself at
+    the first rebalance. Since the ranges are in order, visiting the shards
+    one after another visits every key in order with no merging.
+
+    Rebalancing
+    -----------
+    When an insert leaves its shard above a limit, the caller rebalances:
+    it takes every shard lock, and if the largest shard holds more than
+    Skew() times the average it joins the shards into one tree
+    (OAA::Join), reads new split points at the N-quantiles of the keys and
+    splits the tree there again (OAA::Split). That costs O(n) for the walk
+    plus O(N log n), and since the shards then hold equal parts, a shard
+    needs about (Skew()-1) n/N more keys before the next one. Without skew
+    only the limit is raised. Callers that arrive meanwhile wait on their
+    shard's lock.
+
+    Lookups read the split points without a lock. Each rebalance publishes
+    a new set with a higher generation, which the shards also record; a
+    caller that routed by an older set finds the generations differ once it
+    holds the shard lock and routes again. Old sets are kept until the
+    table is destroyed, as a reader may still be looking at one.
+
+    Interface
+    ---------
+    Get, Put, Upsert, Increment, Erase, Find and Contains may be called
+    from any number of threads. Since no reference into a shard can be
+    handed out once its lock is let go, Get, Upsert and Increment return
+    the data by value, and Find(k,d) copies it to d. Traverse, Display and
+    Size visit the shards in order, locking one at a time, so they see each
+    shard at one moment but not the whole table. Clear and Rebalance lock
+    everything.
+*/
+
+#ifndef _SHARDEDOAA_H
+#define _SHARDEDOAA_H
+
+#include <cstddef>    // size_t
+#include <algorithm>  // sort, upper_bound
+#include <atomic>
+#include <memory>     // unique_ptr
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <iostream>
+#include <oaa.h>      // OAA, LessThan, IsTransparent
+
+namespace fsu
+{
+
+  template < typename K , typename D , class P = LessThan<K> >
+  class ShardedOAA
+  {
+  public:
+    typedef K           KeyType;
+    typedef D           DataType;
+    typedef P           PredicateType;
+    typedef OAA<K,D,P>  TableType;
+
+    static const size_t DefaultShards = 8;
+    static const size_t MinShard      = 1024;  // no rebalance below this shard size
+
+    explicit ShardedOAA (size_t shards = DefaultShards, P p = P());
+    // split points at the quantiles of the keys in [first,last)
+    template < class I >
+    ShardedOAA          (I first, I last, size_t shards = DefaultShards, P p = P());
+    ~ShardedOAA         () {}
+
+    // safe for concurrent callers
+    void     Put       (const KeyType& k, const DataType& d);
+    DataType Get       (const KeyType& k)  { return GetKey(k); }
+    template < class F >  // F is applied to the data of k, under the shard lock
+    DataType Upsert    (const KeyType& k, F f) { return UpsertKey(k, f); }
+    DataType Increment (const KeyType& k, const DataType& delta = DataType(1))
+    {
+      return UpsertKey(k, [&delta](DataType& d) { d += delta; });
+    }
+    void     Erase     (const KeyType& k);
+    bool     Find      (const KeyType& k, DataType& d) const { return FindKey(k, d); }
+    bool     Contains  (const KeyType& k) const              { return ContainsKey(k); }
+
+    // heterogeneous lookup, as in OAA
+    template < class KK >
+    using IfTransparent = typename std::enable_if<IsTransparent<P>::value, KK>::type;
+
+    template < class KK , class = IfTransparent<KK> >
+    DataType Get       (const KK& k)            { return GetKey(k); }
+    template < class KK , class F , class = IfTransparent<KK> >
+    DataType Upsert    (const KK& k, F f)       { return UpsertKey(k, f); }
+    template < class KK , class = IfTransparent<KK> >
+    DataType Increment (const KK& k, const DataType& delta = DataType(1))
+    {
+      return UpsertKey(k, [&delta](DataType& d) { d += delta; });
+    }
+    template < class KK , class = IfTransparent<KK> >
+    bool     Find      (const KK& k, DataType& d) const { return FindKey(k, d); }
+    template < class KK , class = IfTransparent<KK> >
+    bool     Contains  (const KK& k) const      { return ContainsKey(k); }
+
+    // shard by shard, in key order
+    size_t Size     () const;
+    bool   Empty    () const { return Size() == 0; }
+    template < class F >  // f(key, data) for every alive entry
+    void   Traverse (F f) const;
+    void   Display  (std::ostream& os, int kw, int dw,     // key, data widths
+                     std::ios_base::fmtflags kf = std::ios_base::right, // key flag
+                     std::ios_base::fmtflags df = std::ios_base::right // data flag
+                    ) const;
+
+    void   Clear     ();
+    void   Rebalance () { Rebalance(true); }  // new split points even without skew
+
+    size_t NumShards () const         { return shards_.size(); }
+    size_t ShardSize (size_t i) const;
+    double Skew      () const         { return skew_; }
+    void   SetSkew   (double s)       { skew_ = (s < 1.5) ? 1.5 : s; }
+
+  private:
+    ShardedOAA (const ShardedOAA&);
+    ShardedOAA& operator= (const ShardedOAA&);
+
+    struct Shard
+    {
+      explicit Shard (P p) : lock_(), table_(p), gen_(0) {}
+      std::mutex lock_;
+      TableType  table_;
+      size_t     gen_;    // generation of the split points table_ follows
+    };
+
+    struct Bounds         // one published set of split points; never changed
+    {
+      std::vector<K> keys_;
+      size_t         gen_;
+    };
+
+  private: // data
+    std::vector< std::unique_ptr<Shard> >  shards_;
+    std::atomic<const Bounds*>             bounds_;   // current split points
+    std::vector< std::unique_ptr<Bounds> > retired_;  // every set published, current last
+    std::mutex                             rebalance_;
+    std::atomic<size_t>                    limit_;    // shard size that calls for a rebalance
+    PredicateType                          pred_;
+    double                                 skew_;
+
+  private: // methods
+    // the shard owning k, locked in hold; routes again after a rebalance
+    template < class KK >
+    Shard& Route (const KK& k, std::unique_lock<std::mutex>& hold) const;
+
+    void Publish   (std::vector<K>& keys);  // under rebalance_ and every shard lock
+    void Rebalance (bool force);
+    void Grown     (bool grown) { if (grown) Rebalance(false); }
+
+    template < class KK >
+    DataType GetKey (const KK& k)
+    {
+      std::unique_lock<std::mutex> hold;
+      Shard& s = Route(k, hold);
+      DataType d = s.table_.Get(k);
+      bool grown = s.table_.Size() > limit_.load(std::memory_order_relaxed);
+      hold.unlock();
+      Grown(grown);
+      return d;
+    }
+    template < class KK , class F >
+    DataType UpsertKey (const KK& k, F f)
+    {
+      std::unique_lock<std::mutex> hold;
+      Shard& s = Route(k, hold);
+      DataType d = s.table_.Upsert(k, f);
+      bool grown = s.table_.Size() > limit_.load(std::memory_order_relaxed);
+      hold.unlock();
+      Grown(grown);
+      return d;
+    }
+    template < class KK >
+    bool FindKey (const KK& k, DataType& d) const
+    {
+      std::unique_lock<std::mutex> hold;
+      return Route(k, hold).table_.Retrieve(k, d);
+    }
+    template < class KK >
+    bool ContainsKey (const KK& k) const
+    {
+      std::unique_lock<std::mutex> hold;
+      return Route(k, hold).table_.Contains(k);
+    }
+  }; // class ShardedOAA<>
+
+  template < typename K , typename D , class P >
+  ShardedOAA<K,D,P>::ShardedOAA (size_t shards, P p)
+    : shards_(), bounds_(nullptr), retired_(), rebalance_(), limit_(MinShard), pred_(p), skew_(2.0)
+  {
+    if (shards == 0) shards = 1;
+    for (size_t i = 0; i < shards; ++i)
+      shards_.push_back(std::unique_ptr<Shard>(new Shard(pred_)));
+    std::vector<K> none;
+    Publish(none);   // every key goes to shard 0 until the first rebalance
+  }
+
+  template < typename K , typename D , class P >
+  template < class I >
+  ShardedOAA<K,D,P>::ShardedOAA (I first, I last, size_t shards, P p)
+    : shards_(), bounds_(nullptr), retired_(), rebalance_(), limit_(MinShard), pred_(p), skew_(2.0)
+  {
+    if (shards == 0) shards = 1;
+    for (size_t i = 0; i < shards; ++i)
+      shards_.push_back(std::unique_ptr<Shard>(new Shard(pred_)));
+    std::vector<K> sample(first, last), keys;
+    std::sort(sample.begin(), sample.end(), pred_);
+    for (size_t j = 1; j < shards; ++j)
+    {
+      size_t pos = j * sample.size() / shards;
+      if (pos < sample.size() && (keys.empty() || pred_(keys.back(), sample[pos])))
+        keys.push_back(sample[pos]);
+    }
+    Publish(keys);
+  }
+
+  template < typename K , typename D , class P >
+  void ShardedOAA<K,D,P>::Put (const KeyType& k, const DataType& d)
+  {
+    std::unique_lock<std::mutex> hold;
+    Shard& s = Route(k, hold);
+    s.table_.Put(k, d);
+    bool grown = s.table_.Size() > limit_.load(std::memory_order_relaxed);
+    hold.unlock();
+    Grown(grown);
+  }
+
+  template < typename K , typename D , class P >
+  void ShardedOAA<K,D,P>::Erase (const KeyType& k)
+  {
+    std::unique_lock<std::mutex> hold;
+    Route(k, hold).table_.Erase(k);
+  }
+
+  template < typename K , typename D , class P >
+  size_t ShardedOAA<K,D,P>::Size () const
+  {
+    size_t n = 0;
+    for (size_t i = 0; i < shards_.size(); ++i)
+      n += ShardSize(i);
+    return n;
+  }
+
+  template < typename K , typename D , class P >
+  size_t ShardedOAA<K,D,P>::ShardSize (size_t i) const
+  {
+    std::lock_guard<std::mutex> hold(shards_[i]->lock_);
+    return shards_[i]->table_.Size();
+  }
+
+  template < typename K , typename D , class P >
+  template < class F >
+  void ShardedOAA<K,D,P>::Traverse (F f) const
+  {
+    for (size_t i = 0; i < shards_.size(); ++i)
+    {
+      std::lock_guard<std::mutex> hold(shards_[i]->lock_);
+      const TableType& t = shards_[i]->table_;
+      for (typename TableType::ConstIterator j = t.Begin(); j != t.End(); ++j)
+        f(j.Key(), j.Data());
+    }
+  }
+
+  template < typename K , typename D , class P >
+  void ShardedOAA<K,D,P>::Display (std::ostream& os, int kw, int dw, std::ios_base::fmtflags kf, std::ios_base::fmtflags df) const
+  {
+    for (size_t i = 0; i < shards_.size(); ++i)
+    {
+      std::lock_guard<std::mutex> hold(shards_[i]->lock_);
+      shards_[i]->table_.Display(os, kw, dw, kf, df);
+    }
+  }
+
+  template < typename K , typename D , class P >
+  void ShardedOAA<K,D,P>::Clear ()
+  // the split points stay
+  {
+    std::lock_guard<std::mutex> r(rebalance_);
+    for (size_t i = 0; i < shards_.size(); ++i)
+    {
+      std::lock_guard<std::mutex> hold(shards_[i]->lock_);
+      shards_[i]->table_.Clear();
+    }
+    limit_.store(MinShard, std::memory_order_relaxed);
+  }
+
+  // private methods
+
+  template < typename K , typename D , class P >
+  template < class KK >
+  typename ShardedOAA<K,D,P>::Shard& ShardedOAA<K,D,P>::Route (const KK& k, std::unique_lock<std::mutex>& hold) const
+  {
+    const PredicateType& pred = pred_;
+    for (;;)
+    {
+      const Bounds * b = bounds_.load(std::memory_order_acquire);
+      size_t i = std::upper_bound(b->keys_.begin(), b->keys_.end(), k,
+                                  [&pred](const KK& a, const K& bk) { return pred(a, bk); })
+                 - b->keys_.begin();
+      Shard& s = *shards_[i];
+      std::unique_lock<std::mutex> l(s.lock_);
+      if (s.gen_ == b->gen_)
+      {
+        hold = std::move(l);
+        return s;
+      }
+    }
+  }
+
+  template < typename K , typename D , class P >
+  void ShardedOAA<K,D,P>::Publish (std::vector<K>& keys)
+  {
+    std::unique_ptr<Bounds> b(new Bounds);
+    b->keys_.swap(keys);
+    b->gen_ = retired_.size();
+    for (size_t i = 0; i < shards_.size(); ++i)
+      shards_[i]->gen_ = b->gen_;
+    bounds_.store(b.get(), std::memory_order_release);
+    retired_.push_back(std::move(b));
+  }
+
+  template < typename K , typename D , class P >
+  void ShardedOAA<K,D,P>::Rebalance (bool force)
+  /*
+    Shard locks are taken in index order. Route holds at most one shard lock
+    at a time, so this cannot deadlock with callers; a second caller finding
+    a rebalance under way leaves it to the first.
+  */
+  {
+    std::unique_lock<std::mutex> r(rebalance_, std::defer_lock);
+    if (force)
+      r.lock();
+    else if (!r.try_lock())
+      return;
+
+    size_t n = shards_.size();
+    std::vector< std::unique_lock<std::mutex> > held;
+    held.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+      held.push_back(std::unique_lock<std::mutex>(shards_[i]->lock_));
+
+    size_t total = 0, most = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      size_t s = shards_[i]->table_.Size();
+      total += s;
+      if (s > most) most = s;
+    }
+    if (!force && (double)most <= skew_ * total / n)
+    {
+      // growth without skew: wait for the next skew_-fold rise
+      limit_.store(std::max((size_t)MinShard, (size_t)(skew_ * most)), std::memory_order_relaxed);
+      return;
+    }
+
+    TableType all(pred_);
+    for (size_t i = 0; i < n; ++i)
+      all.Join(all, shards_[i]->table_);
+    total = all.Size();
+
+    std::vector<K> keys;
+    typename TableType::ConstIterator it = all.Begin();
+    size_t pos = 0;
+    for (size_t j = 1; j < n; ++j)
+    {
+      size_t want = j * total / n;
+      if (want >= total) break;
+      for (; pos < want; ++pos) ++it;
+      if (keys.empty() || pred_(keys.back(), it.Key()))
+        keys.push_back(it.Key());
+    }
+
+    for (size_t j = 0; j < keys.size(); ++j)
+    {
+      std::pair<TableType,TableType> p = all.Split(keys[j]);
+      shards_[j]->table_ = std::move(p.first);
+      all = std::move(p.second);
+    }
+    shards_[keys.size()]->table_ = std::move(all);
+    for (size_t i = 0; i < n; ++i)
+      shards_[i]->table_.Size();   // count the pieces now, under the locks
+    limit_.store(std::max((size_t)MinShard, (size_t)(skew_ * total / n)), std::memory_order_relaxed);
+    Publish(keys);
+  }
+
+} // namespace fsu
+
+#endif
@@ -0,0 +1,314 @@
+/*
+    slaballoc.h
+    10/16/26
+
+    Node allocation policies for OAA<K,D,P,A>.
+
+    The fourth template parameter of OAA is a class template A<T> that hands out
+    storage for tree nodes. Two policies are supplied:
+
+    SlabAllocator<T> (the default)
+    ------------------------------
+    Objects are carved out of large slabs of raw memory. A slot freed by Delete
+    is pushed on an intrusive free list and is recycled by the next New, so
+    steady-state churn (Erase followed by Get) never reaches malloc. Slabs grow
+    geometrically from MinSlab up to MaxSlab slots. Release() hands every slab
+    back to the system at once, which lets OAA::Clear() and ~OAA() skip the
+    node-by-node walk whenever the node type is trivially destructible (and
+    still skip the per-node free otherwise).
+
+    HeapAllocator<T>
+    ----------------
+    One new/delete per object, i.e. the original OAA behavior. It cannot
+    release in bulk, so the container falls back to deleting node by node.
+
+    Shared storage
+    --------------
+    OAA::Split leaves the nodes of one tree in two containers. After
+    a.Share(b) the allocators a and b both keep a's slabs alive, each slab
+    being reference counted, so either may delete objects made by the other
+    and each may Release on its own: a slab goes back to the system with the
+    last allocator holding it. Each allocator recycles through its own free
+    list, so two sharers may be used from different threads. a.Absorb(b)
+    takes over everything b holds, as OAA::Join does. Share does not know
+    how the live objects are divided; SetInUse(n) tells it afterwards.
+
+    An allocator's capacity is the slots it can account for: its live
+    objects, its free list and its bump region. A slot is in exactly one of
+    these for exactly one sharer, so Reserve counts only what this
+    allocator can hand out, and the sharers' BytesReserved add up to the
+    storage they hold together. Both are right once SetInUse is.
+
+  Policy interface (what OAA relies on)
+  -------------------------------------
+    T*     New (args...)     construct a T in fresh storage, nullptr on failure
+    void   Delete (T*)       destroy and recycle
+    void   Reserve (n)       make room for n objects in total
+    bool   CanRelease ()     true if Release() may be used
+    void   Release ()        drop all storage; every object must already be destroyed
+    void   Swap (A&)         exchange contents
+    void   Share (A& a)      a also keeps this storage alive (a is empty)
+    void   Absorb (A& a)     take over a's storage and objects; a ends empty
+    void   SetInUse (n)      n live objects are this allocator's to delete
+    size_t BytesInUse ()     bytes held by live objects
+    size_t BytesReserved ()  bytes this allocator can account for (its share, if shared)
+*/
+
+#ifndef _SLABALLOC_H
+#define _SLABALLOC_H
+
+#include <cstddef>    // size_t, max_align_t
+#include <new>        // placement new, std::nothrow
+#include <utility>    // std::forward, std::swap
+#include <type_traits>
+#include <memory>     // shared_ptr
+#include <vector>
+#include <algorithm>  // sort, unique
+#include <iostream>
+
+namespace fsu
+{
+
+  template < typename T >
+  class HeapAllocator
+  {
+  public:
+    HeapAllocator () : count_(0) {}
+
+    template < typename... Args >
+    T* New (Args&&... args)
+    {
+      T * t = new(std::nothrow) T(std::forward<Args>(args)...);
+      if (t == nullptr)
+        std::cerr << "** HeapAllocator memory allocation failure\n";
+      else
+        ++count_;
+      return t;
+    }
+
+    void   Delete        (T* t)  { delete t; --count_; }
+    void   Reserve       (size_t) {}
+    bool   CanRelease    () const { return false; }
+    void   Release       () {}
+    void   Swap          (HeapAllocator& a) { std::swap(count_, a.count_); }
+    void   Share         (HeapAllocator&) {}  // every object owns its storage
+    void   Absorb        (HeapAllocator& a) { count_ += a.count_; a.count_ = 0; }
+    void   SetInUse      (size_t n) { count_ = n; }
+    size_t BytesInUse    () const { return count_ * sizeof(T); }
+    size_t BytesReserved () const { return count_ * sizeof(T); }
+
+  private:
+    HeapAllocator (const HeapAllocator&);
+    HeapAllocator& operator= (const HeapAllocator&);
+
+    size_t count_;
+  }; // class HeapAllocator<>
+
+  template < typename T >
+  class SlabAllocator
+  {
+  public:
+    static const size_t MinSlab = 64;       // slots in the first slab
+    static const size_t MaxSlab = 1 << 16;  // growth stops doubling here
+
+             SlabAllocator  ();
+             ~SlabAllocator ();
+
+    template < typename... Args >
+    T*     New           (Args&&... args);
+    void   Delete        (T* t);
+    void   Reserve       (size_t n);
+    bool   CanRelease    () const { return true; }
+    void   Release       ();
+    void   Swap          (SlabAllocator& a);
+    void   Share         (SlabAllocator& a);
+    void   Absorb        (SlabAllocator& a);
+    void   SetInUse      (size_t n) { inUse_ = n; }
+    size_t BytesInUse    () const { return inUse_ * sizeof(Slot); }
+    size_t BytesReserved () const { return Capacity() * sizeof(Slot); }
+
+  private:
+    SlabAllocator (const SlabAllocator&);            // storage is shared only through Share
+    SlabAllocator& operator= (const SlabAllocator&);
+
+    union Slot
+    {
+      Slot * next_;  // valid while the slot is on the free list
+      typename std::aligned_storage<sizeof(T), alignof(T)>::type obj_;
+    };
+
+    struct Slab      // header; the slots follow it in the same block
+    {
+      size_t capacity_;
+      size_t pad_;     // keeps the slots aligned
+      Slot * Slots () { return reinterpret_cast<Slot*>(this + 1); }
+      static void Free (Slab * s) { ::operator delete(s); }
+    };
+
+    static_assert(sizeof(Slab) % alignof(Slot) == 0, "SlabAllocator: slot misaligned after header");
+
+    typedef std::shared_ptr<Slab> SlabPtr;
+
+    size_t Capacity  () const { return inUse_ + numFree_ + (end_ - cur_); }
+    bool   Grow      (size_t n); // adds a slab with at least n slots
+    void   FreeRest  ();         // puts the unused bump region on the free list
+    void   AddSlabs  (const std::vector<SlabPtr>& s); // co-own s as well
+
+    std::vector<SlabPtr> slabs_; // every slab held, shared or not
+    Slot * free_;      // recycled slots
+    Slot * cur_;       // bump pointer into the newest slab
+    Slot * end_;
+    size_t numFree_;   // slots on the free list
+    size_t inUse_;     // slots holding live objects this allocator answers for
+  }; // class SlabAllocator<>
+
+  template < typename T >
+  SlabAllocator<T>::SlabAllocator ()
+    : slabs_(), free_(nullptr), cur_(nullptr), end_(nullptr),
+      numFree_(0), inUse_(0)
+  {}
+
+  template < typename T >
+  SlabAllocator<T>::~SlabAllocator ()
+  {
+    Release();
+  }
+
+  template < typename T >
+  template < typename... Args >
+  T* SlabAllocator<T>::New (Args&&... args)
+  {
+    Slot * s;
+    if (free_ != nullptr)
+    {
+      s = free_;
+      free_ = free_->next_;
+      --numFree_;
+    }
+    else
+    {
+      if (cur_ == end_)
+      {
+        size_t n = (Capacity() < MinSlab) ? MinSlab : Capacity();
+        if (n > MaxSlab) n = MaxSlab;
+        if (!Grow(n))
+          return nullptr;
+      }
+      s = cur_++;
+    }
+    ++inUse_;
+    return new(&s->obj_) T(std::forward<Args>(args)...);
+  }
+
+  template < typename T >
+  void SlabAllocator<T>::Delete (T* t)
+  {
+    if (t == nullptr) return;
+    t->~T();
+    Slot * s = reinterpret_cast<Slot*>(t);
+    s->next_ = free_;
+    free_ = s;
+    ++numFree_;
+    --inUse_;
+  }
+
+  template < typename T >
+  void SlabAllocator<T>::Reserve (size_t n)
+  // post: n objects in total fit without another trip to the system
+  {
+    if (n > Capacity())
+      Grow(n - Capacity());
+  }
+
+  template < typename T >
+  void SlabAllocator<T>::Release ()
+  // a slab shared with another allocator lives on until that one lets go
+  {
+    slabs_.clear();
+    free_ = cur_ = end_ = nullptr;
+    numFree_ = inUse_ = 0;
+  }
+
+  template < typename T >
+  void SlabAllocator<T>::Swap (SlabAllocator& a)
+  {
+    std::swap(slabs_, a.slabs_);
+    std::swap(free_, a.free_);
+    std::swap(cur_, a.cur_);
+    std::swap(end_, a.end_);
+    std::swap(numFree_, a.numFree_);
+    std::swap(inUse_, a.inUse_);
+  }
+
+  template < typename T >
+  void SlabAllocator<T>::Share (SlabAllocator& a)
+  {
+    a.AddSlabs(slabs_);
+  }
+
+  template < typename T >
+  void SlabAllocator<T>::Absorb (SlabAllocator& a)
+  // O(slabs + a's free slots + what is left of one bump region)
+  {
+    if (&a == this) return;
+    AddSlabs(a.slabs_);
+    if (cur_ == end_)          // keep one bump region
+    {
+      std::swap(cur_, a.cur_);
+      std::swap(end_, a.end_);
+    }
+    a.FreeRest();              // the other goes on a's free list,
+    if (a.free_ != nullptr)    // which goes in front of ours
+    {
+      Slot * last = a.free_;
+      while (last->next_ != nullptr)
+        last = last->next_;
+      last->next_ = free_;
+      free_ = a.free_;
+      a.free_ = nullptr;
+    }
+    numFree_ += a.numFree_;
+    inUse_ += a.inUse_;
+    a.Release();
+  }
+
+  template < typename T >
+  void SlabAllocator<T>::AddSlabs (const std::vector<SlabPtr>& s)
+  {
+    slabs_.insert(slabs_.end(), s.begin(), s.end());
+    std::sort(slabs_.begin(), slabs_.end());  // a slab is held once
+    slabs_.erase(std::unique(slabs_.begin(), slabs_.end()), slabs_.end());
+  }
+
+  template < typename T >
+  void SlabAllocator<T>::FreeRest ()
+  {
+    while (cur_ != end_)
+    {
+      cur_->next_ = free_;
+      free_ = cur_++;
+      ++numFree_;
+    }
+  }
+
+  template < typename T >
+  bool SlabAllocator<T>::Grow (size_t n)
+  {
+    size_t bytes = sizeof(Slab) + n * sizeof(Slot);
+    Slab * s = static_cast<Slab*>(::operator new(bytes, std::nothrow));
+    if (s == nullptr)
+    {
+      std::cerr << "** SlabAllocator memory allocation failure\n";
+      return false;
+    }
+    FreeRest();  // whatever is left of the old bump region goes on the free list
+    s->capacity_ = n;
+    slabs_.push_back(SlabPtr(s, &Slab::Free));
+    cur_ = s->Slots();
+    end_ = cur_ + n;
+    return true;
+  }
+
+} // namespace fsu
+
+#endif
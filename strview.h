@@ -0,0 +1,98 @@
+/*
+    strview.h
+    10/16/26
+
+    StringView: a non-owning (pointer, length) view of characters, and
+    StringLess: a transparent predicate that orders fsu::String and
+    StringView interchangeably. It also has a three-way Compare, so an OAA
+    spends one comparison per level on its descents.
+
+    With P = StringLess an OAA<fsu::String,D,P> accepts a StringView (or a
+    const char*) wherever it accepts a key: Find, Contains, Retrieve, Get,
+    operator[], Upsert and Increment compare the view against the stored
+    Strings directly, and an fsu::String is built from the view only when a
+    new node is created. A tokenizer can then probe the table straight out of
+    its read buffer, paying for a String once per distinct word instead of
+    once per token.
+
+    Order is that of memcmp over the shared prefix, the shorter string first
+    on a tie - the order of fsu::String for any text without embedded nulls
+    or bytes above 127, which covers everything Wordify() produces.
+
+    A view does not own its characters, so it must not outlive the buffer it
+    was made from.
+*/
+
+#ifndef _STRVIEW_H
+#define _STRVIEW_H
+
+#include <cstddef>    // size_t
+#include <cstring>    // strlen, memcmp
+#include <iostream>
+#include <xstring.h>
+
+namespace fsu
+{
+
+  class StringView
+  {
+  public:
+    StringView  () : str_(""), size_(0) {}
+    StringView  (const char* s) : str_(s), size_(std::strlen(s)) {}
+    StringView  (const char* s, size_t n) : str_(s), size_(n) {}
+    StringView  (const String& s) : str_(s.Cstr()), size_(s.Size()) {}
+
+    const char* Data  () const { return str_; }
+    size_t      Size  () const { return size_; }
+    bool        Empty () const { return size_ == 0; }
+    char        operator [] (size_t i) const { return str_[i]; }
+
+    operator String () const;  // copies the characters into a new String
+
+    // negative, zero or positive as a is before, equal to or after b
+    static int Compare (StringView a, StringView b)
+    {
+      size_t n = (a.size_ < b.size_) ? a.size_ : b.size_;
+      int c = (n == 0) ? 0 : std::memcmp(a.str_, b.str_, n);
+      if (c != 0) return c;
+      return (a.size_ < b.size_) ? -1 : (a.size_ > b.size_);
+    }
+
+  private:
+    const char * str_;
+    size_t       size_;
+  }; // class StringView
+
+  inline StringView::operator String () const
+  {
+    String s;
+    s.SetSize(size_);
+    for (size_t i = 0; i < size_; ++i)
+      s[i] = str_[i];
+    return s;
+  }
+
+  inline std::ostream& operator << (std::ostream& os, StringView v)
+  {
+    return os.write(v.Data(), v.Size());
+  }
+
+  class StringLess
+  {
+  public:
+    typedef void is_transparent;  // OAA may compare keys with other types
+
+    bool operator () (StringView a, StringView b) const
+    {
+      return StringView::Compare(a,b) < 0;
+    }
+
+    int Compare (StringView a, StringView b) const  // three-way, see compare3.h
+    {
+      return StringView::Compare(a,b);
+    }
+  }; // class StringLess
+
+} // namespace fsu
+
+#endif
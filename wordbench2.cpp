@@ -27,9 +27,56 @@ UPDATE:
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <string>     // read buffer
+#include <vector>
+#include <thread>
+#include <system_error>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <algorithm>  // sort, max, min
+#include <sys/stat.h> // stat
+#include <mapfile.h>
+#include <dirent.h>   // opendir, readdir
 #include "wordify.cpp"
 
-WordBench::WordBench() : count_(0)
+// the characters operator>> stops at in the "C" locale
+static bool IsSpace(char c)
+{
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// job(0), ..., job(n-1), one thread each; a job whose thread the system
+// will not start runs on the calling thread instead
+template < class F >
+static void RunAll(size_t n, F job)
+{
+  std::vector<std::thread> pool;
+  std::vector<size_t> left;
+  pool.reserve(n);     // a started thread is never lost to a reallocation
+  for (size_t i = 0; i < n; ++i)
+  {
+    try
+    {
+      pool.push_back(std::thread(job, i));
+    }
+    catch (const std::system_error&)
+    {
+      left.push_back(i);
+    }
+  }
+  if (!left.empty())
+    std::cerr << " ** could not start " << left.size() << " of " << n
+              << " threads; running their work here\n";
+  for (size_t i = 0; i < left.size(); ++i)
+    job(left[i]);
+  for (size_t i = 0; i < pool.size(); ++i)
+    pool[i].join();
+}
+
+const unsigned WordBench::MaxThreads;
+
+WordBench::WordBench() : count_(0), store_(TREE), threads_(1)
 {
 }
   
@@ -39,30 +86,334 @@ WordBench::~WordBench()
 }
 
 bool WordBench::ReadText(const fsu::String& infile)
+/*
+  The file is mapped and scanned in place (see ScanRange); each token is
+  copied into a scratch buffer that keeps its capacity, so a word already
+  in the table costs no allocation. What cannot be mapped, a pipe say, is
+  read as a stream.
+*/
+{
+  fsu::MappedFile file;
+  if (!file.Open(infile.Cstr()))
+    return ReadStream(infile);
+  infiles_.PushBack(infile);
+  if (threads_ > 1)
+    return ReadParallel(file);
+  file.Sequential();
+  size_t numwords = ScanRange(file, 0, file.Size(), store_ == HASH ? nullptr : &frequency_);
+  if (store_ == HASH)   // ordered from here on
+  {
+    counter_.LoadInto(frequency_);
+    counter_.Clear();
+  }
+  std::cout << "Words read: " << numwords << std::endl;
+  return true;
+}
+
+bool WordBench::ReadStream(const fsu::String& infile)
 {
   std::ifstream fstr;
   fstr.open(infile.Cstr());
   if(fstr.fail())   return false; // driver program prints error message
   else
   {
-    fsu::String str;
     infiles_.PushBack(infile);
     unsigned int numwords = 0;
-		fsu::String current_word;
+		std::string current_word;  // keeps its capacity from token to token
 		while (fstr >> current_word)
 		{
-			Wordify(current_word);
-			if (current_word.Length() != 0)
+			size_t length = Wordify(&current_word[0], current_word.size());
+			if (length != 0)
 			{
-				++frequency_[str];
+				// a key is built only for a new word; repeats skip rebalancing
+				if (store_ == HASH)
+					counter_.Increment(fsu::StringView(current_word.data(), length));
+				else
+					frequency_.Increment(fsu::StringView(current_word.data(), length));
 				++numwords;
 			} // end if
 		}
+		if (store_ == HASH)   // ordered from here on
+		{
+			counter_.LoadInto(frequency_);
+			counter_.Clear();
+		}
 		std::cout << "Words read: " << numwords << std::endl;
     return true;
   }// outer-if
 }
 
+bool WordBench::ReadParallel(const fsu::MappedFile& file)
+{
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point start = Clock::now();
+  file.Sequential();
+
+  // worker i counts the words starting in [cut[i], cut[i+1])
+  size_t n = threads_;
+  std::vector<size_t> cut(n + 1), words(n, 0);
+  for (size_t i = 0; i <= n; ++i)
+    cut[i] = i * file.Size() / n;
+  std::vector<TableType> part(store_ == HASH ? 0 : n);
+  RunAll(n, [this, &file, &cut, &words, &part](size_t i)
+  {
+    words[i] = ScanRange(file, cut[i], cut[i+1], part.empty() ? nullptr : &part[i]);
+  });
+  Clock::time_point counted = Clock::now();
+
+  Reduce(part);
+  Clock::time_point merged = Clock::now();
+
+  size_t numwords = 0;
+  for (size_t i = 0; i < n; ++i)
+    numwords += words[i];
+  typedef std::chrono::duration<double, std::milli> Ms;
+  std::cout << "Words read: " << numwords << std::endl;
+  std::cout << std::fixed << std::setprecision(1)
+            << "  count " << Ms(counted - start).count() << " ms (" << n << " threads), merge "
+            << Ms(merged - counted).count() << " ms" << std::endl;
+  return true;
+}
+
+void WordBench::Reduce(std::vector<TableType>& part)
+// the workers' counts into frequency_
+{
+  if (store_ == HASH)
+  {
+    counter_.LoadInto(frequency_);
+    counter_.Clear();
+    return;
+  }
+  for (size_t step = 1; step < part.size(); step *= 2)  // merge neighbors, one thread per pair
+  {
+    size_t pairs = (part.size() - step + 2 * step - 1) / (2 * step);
+    RunAll(pairs, [&part, step](size_t j)
+    {
+      size_t i = 2 * step * j;
+      part[i].Merge(std::move(part[i + step]), fsu::Accumulate<DataType>());
+    });
+  }
+  frequency_.Merge(std::move(part[0]), fsu::Accumulate<DataType>());
+}
+
+// bytes [begin,end) of file number file_ in a ReadTexts list
+struct Piece
+{
+  size_t file_, begin_, end_;
+  size_t Size () const { return end_ - begin_; }
+};
+
+// one deque of pieces per worker, each largest first; a worker whose deque
+// is empty takes the largest piece at the front of the others
+class PieceQueues
+{
+public:
+  explicit PieceQueues (size_t n) : queue_(n), lock_(n) {}
+
+  void Deal (std::vector<Piece>& pieces)  // round robin, largest first
+  {
+    std::stable_sort(pieces.begin(), pieces.end(),
+                     [](const Piece& a, const Piece& b) { return a.Size() > b.Size(); });
+    for (size_t i = 0; i < pieces.size(); ++i)
+      queue_[i % queue_.size()].push_back(pieces[i]);
+  }
+
+  bool Next (size_t w, Piece& p)  // false once every deque is empty
+  {
+    if (Pop(w, p)) return true;
+    for (;;)    // nothing is added after Deal, so empty deques stay empty
+    {
+      size_t victim = w, most = 0;
+      for (size_t v = 0; v < queue_.size(); ++v)
+      {
+        std::lock_guard<std::mutex> hold(lock_[v]);
+        if (!queue_[v].empty() && queue_[v].front().Size() + 1 > most)
+        {
+          victim = v;
+          most = queue_[v].front().Size() + 1;
+        }
+      }
+      if (victim == w) return false;
+      if (Pop(victim, p)) return true;
+    }
+  }
+
+private:
+  bool Pop (size_t v, Piece& p)
+  {
+    std::lock_guard<std::mutex> hold(lock_[v]);
+    if (queue_[v].empty()) return false;
+    p = queue_[v].front();
+    queue_[v].pop_front();
+    return true;
+  }
+
+  std::vector< std::deque<Piece> > queue_;
+  std::vector< std::mutex >        lock_;
+};
+
+bool WordBench::ReadTexts(const std::vector<fsu::String>& paths, std::vector<fsu::String>* failed)
+/*
+  Every file is mapped once, while planning, and its pieces are all read
+  from that mapping, so a file is counted whole or not at all even if it
+  changes or goes away in the meantime. Files bigger than a quarter of a
+  worker's share of the bytes (and 1 MB) are cut into pieces of that size
+  (a word is counted in the piece it starts in, see CountRange), so one
+  large file cannot keep a single worker busy while the rest wait. Every
+  piece goes into the worker deques largest first. Each worker counts into
+  a table of its own (TREE) or into counter_ (HASH), and the tables are
+  merged as in ReadText.
+*/
+{
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point start = Clock::now();
+  const size_t MinPiece = 1 << 20;
+  size_t n = threads_, total = 0;
+  std::vector<char> ok(paths.size(), 0);
+  std::vector<fsu::MappedFile> file(paths.size());   // held until every piece is counted
+  for (size_t i = 0; i < paths.size(); ++i)
+  {
+    if (file[i].Open(paths[i].Cstr()))
+    {
+      ok[i] = 1;
+      file[i].Sequential();
+      total += file[i].Size();
+    }
+  }
+  size_t piece = std::max(MinPiece, total / (4 * n) + 1);
+  std::vector<Piece> pieces;
+  for (size_t i = 0; i < paths.size(); ++i)
+    for (size_t b = 0; ok[i] && b < file[i].Size(); b += piece)
+    {
+      Piece p = { i, b, std::min(b + piece, file[i].Size()) };
+      pieces.push_back(p);
+    }
+  PieceQueues queues(n);
+  queues.Deal(pieces);
+  Clock::time_point planned = Clock::now();
+
+  std::vector<TableType> part(store_ == HASH ? 0 : n);
+  std::vector<size_t> words(n, 0);
+  RunAll(n, [this, &file, &queues, &part, &words](size_t w)
+  {
+    Piece p;
+    while (queues.Next(w, p))
+      words[w] += ScanRange(file[p.file_], p.begin_, p.end_, part.empty() ? nullptr : &part[w]);
+  });
+  Clock::time_point counted = Clock::now();
+
+  Reduce(part);
+  Clock::time_point merged = Clock::now();
+
+  size_t numwords = 0, numfiles = 0;
+  for (size_t w = 0; w < n; ++w)
+    numwords += words[w];
+  for (size_t i = 0; i < paths.size(); ++i)
+  {
+    if (ok[i])
+    {
+      infiles_.PushBack(paths[i]);
+      ++numfiles;
+    }
+    else if (failed != nullptr)
+    {
+      failed->push_back(paths[i]);
+    }
+  }
+  typedef std::chrono::duration<double, std::milli> Ms;
+  std::cout << "Files read: " << numfiles << "  Words read: " << numwords << std::endl;
+  std::cout << std::fixed << std::setprecision(1)
+            << "  plan " << Ms(planned - start).count() << " ms (" << pieces.size() << " pieces), count "
+            << Ms(counted - planned).count() << " ms (" << n << " threads), merge "
+            << Ms(merged - counted).count() << " ms" << std::endl;
+  return numfiles == paths.size();
+}
+
+// the regular files under dir (and its subdirectories if recursive), in name order
+static bool ListFiles(const std::string& dir, bool recursive, std::vector<std::string>& out)
+{
+  DIR * d = opendir(dir.c_str());
+  if (d == nullptr) return false;
+  std::vector<std::string> subdirs;
+  for (struct dirent * e = readdir(d); e != nullptr; e = readdir(d))
+  {
+    std::string name = e->d_name;
+    if (name == "." || name == "..") continue;
+    std::string path = dir + '/' + name;
+    struct stat st;
+    if (lstat(path.c_str(), &st) != 0) continue;  // symbolic links to directories are not followed
+    if (S_ISDIR(st.st_mode))
+    {
+      if (recursive) subdirs.push_back(path);
+    }
+    else if (S_ISREG(st.st_mode) || (S_ISLNK(st.st_mode) && stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)))
+    {
+      out.push_back(path);
+    }
+  }
+  closedir(d);
+  for (size_t i = 0; i < subdirs.size(); ++i)
+    ListFiles(subdirs[i], recursive, out);
+  return true;
+}
+
+bool WordBench::ReadDirectory(const fsu::String& dir, bool recursive, std::vector<fsu::String>* failed)
+{
+  std::vector<std::string> names;
+  if (!ListFiles(dir.Cstr(), recursive, names)) return false;
+  std::sort(names.begin(), names.end());
+  std::vector<fsu::String> paths;
+  for (size_t i = 0; i < names.size(); ++i)
+    paths.push_back(fsu::String(names[i].c_str()));
+  return ReadTexts(paths, failed);
+}
+
+size_t WordBench::ScanRange(const fsu::MappedFile& file, size_t begin, size_t end, TableType* table)
+// CountRange a window at a time, giving back the pages of each window passed
+{
+  const size_t Window = 1 << 24;
+  std::string scratch;   // keeps its capacity from token to token
+  size_t numwords = 0;
+  for (size_t w = begin; w < end; w += Window)
+  {
+    size_t e = (end - w < Window) ? end : w + Window;
+    numwords += CountRange(file.Data(), file.Size(), w, e, table, scratch);
+    file.Release(w, e);
+  }
+  return numwords;
+}
+
+size_t WordBench::CountRange(const char* s, size_t n, size_t begin, size_t end, TableType* table, std::string& scratch)
+/*
+  The tokens of s[0..n), as operator>> makes them, that start in
+  [begin,end): a token running in from before begin belongs to the range
+  before, and the last one may run on past end. Cutting s anywhere thus
+  leaves every token to exactly one range.
+*/
+{
+  size_t numwords = 0, i = begin;
+  if (i > 0 && !IsSpace(s[i - 1]))
+    while (i < n && !IsSpace(s[i])) ++i;
+  for (;;)
+  {
+    while (i < end && IsSpace(s[i])) ++i;
+    if (i >= end) break;
+    size_t start = i;
+    while (i < n && !IsSpace(s[i])) ++i;
+    scratch.assign(s + start, i - start);
+    size_t length = Wordify(&scratch[0], scratch.size());
+    if (length != 0)
+    {
+      if (table != nullptr)
+        table->Increment(fsu::StringView(scratch.data(), length));
+      else
+        counter_.Increment(fsu::StringView(scratch.data(), length));
+      ++numwords;
+    }
+  }
+  return numwords;
+}
+
 bool WordBench::WriteReport(const fsu::String& outfile, unsigned short kw, unsigned short dw,
 																									std::ios_base::fmtflags kf, std::ios_base::fmtflags df ) const
 {
@@ -10,6 +10,42 @@
   Wordify is a helper method (included as a slave file) written in wordify.cpp
   that is used to cleanup the string passed to it by reference. 
 
+  frequency_ orders its keys with ThreeWay<KeyType>, a transparent three-way
+  predicate: ReadText looks a token up as a StringView into its read buffer,
+  a key is only made for a word the table has not seen, and each level of
+  the descent compares the characters once. Keys are InlineStrings, so a
+  typical word is stored in the node itself and compared as two words.
+
+  SetStore(HASH) counts into a HashCounter instead, a lock-free hash table
+  meant for counting from many threads; at the end of ReadText its counts
+  are sorted and merged into frequency_ (HashCounter::LoadInto), which
+  stays the ordered table that reports read. SetStore(TREE) is the default.
+
+  ReadText maps the file (MappedFile, mapfile.h) and scans the tokens in
+  place, as operator>> would cut them. Each token is copied into a scratch
+  buffer that keeps its capacity and Wordified there, so a word already
+  counted costs no allocation. The pages are given back a 16 MB window at
+  a time as the scan passes them, so a file of many GB needs no more memory
+  than the table. A file that cannot be mapped is read with operator>>.
+
+  With SetThreads(n), n > 1, ReadText cuts the mapped file into n byte
+  ranges, each counting the tokens that start in it, and has one thread
+  per range count them: into a table of its own with the TREE store (the
+  tables are then merged pairwise, in parallel, into frequency_ with
+  OAA::Merge) or straight into counter_ with the HASH store. Tokens and
+  counts are those of the serial path. It prints the time spent counting
+  and merging. SetThreads keeps n within 1..MaxThreads, and a range whose
+  thread the system will not start is counted on the calling thread.
+
+  ReadTexts(paths) reads many files at once on Threads() workers, and
+  ReadDirectory(dir,recursive) reads the regular files of a directory.
+  Each file is mapped once, so it is counted whole or not at all. Large
+  files are cut into pieces at byte offsets (a token belongs to the
+  piece it starts in), the pieces are dealt to per-worker deques largest
+  first, and a worker that runs dry takes the largest piece left in
+  another's deque. Both return false if a file could not be read; its name
+  goes to *failed.
+
 */
 
 #ifndef WORDBENCH_H
@@ -17,6 +53,13 @@
 #include "xstring.h"
 #include <list.h>
 #include <oaa.h>
+#include <strview.h>
+#include <compare3.h>
+#include <inlstr.h>
+#include <hashcount.h>
+#include <vector>
+#include <string>
+#include <mapfile.h>
 
 
 class WordBench
@@ -25,6 +68,8 @@ public:
   WordBench         ();
   virtual ~WordBench(); 
   bool ReadText     (const fsu::String& infile);
+  bool ReadTexts    (const std::vector<fsu::String>& paths, std::vector<fsu::String>* failed = nullptr);
+  bool ReadDirectory(const fsu::String& dir, bool recursive = false, std::vector<fsu::String>* failed = nullptr);
   bool WriteReport  (const fsu::String& outfile, unsigned short kw = 15, unsigned short dw = 15,
                      std::ios_base::fmtflags kf = std::ios_base::left, // key justify
                      std::ios_base::fmtflags df = std::ios_base::right // data justify
@@ -32,14 +77,35 @@ public:
   void ShowSummary  () const;
   void ClearData    ();
 
+  enum Store { TREE, HASH };     // where ReadText counts
+  void  SetStore    (Store s) { store_ = s; }
+  Store GetStore    () const  { return store_; }
+
+  static const unsigned MaxThreads = 256;
+  void     SetThreads (unsigned n)  // 1: serial ReadText
+  { threads_ = (n == 0) ? 1 : (n > MaxThreads) ? MaxThreads : n; }
+  unsigned Threads    () const     { return threads_; }
+
 private:
-  typedef fsu::String             KeyType;
+  typedef fsu::InlineString       KeyType; // words up to 15 chars live in the node
   typedef size_t                  DataType;
+  typedef fsu::OAA < KeyType, DataType, fsu::ThreeWay<KeyType> > TableType;
 
   size_t                          count_;  //number of valid words read
-  fsu::OAA  < KeyType, DataType > frequency_;
+  TableType                       frequency_; // probed with StringViews
   fsu::List < fsu::String >       infiles_;
-  static void Wordify  (fsu::String&);
+  Store                           store_;
+  fsu::HashCounter                counter_; // used by ReadText when store_ == HASH
+  unsigned                        threads_; // ReadText workers
+  static void   Wordify  (fsu::String&);
+  static size_t Wordify  (char* s, size_t n); // in place; returns the new length
+
+  bool   ReadStream   (const fsu::String& infile);   // operator>>, for what cannot be mapped
+  bool   ReadParallel (const fsu::MappedFile& file);
+  // the words starting in [begin,end) into table, or counter_ if nullptr
+  size_t ScanRange    (const fsu::MappedFile& file, size_t begin, size_t end, TableType* table);
+  size_t CountRange   (const char* s, size_t n, size_t begin, size_t end, TableType* table, std::string& scratch);
+  void   Reduce       (std::vector<TableType>& part);         // part (or counter_) into frequency_
 };
 //#include <wordify.cpp>
 #endif
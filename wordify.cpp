@@ -29,6 +29,10 @@ acceptance:
 
 s.Element(i) returns s[i] by value if i < s.Size() and returns '\0' otherwise.
 
+The rules are written once, in wordify(), for anything with Element,
+operator[] and SetSize: Wordify(String&) cleans a String and Wordify(ptr,n)
+cleans n chars in place and returns the length of the word left at ptr.
+
 */
 
 #include <iostream>
@@ -83,7 +87,23 @@ char toLowerCase(const char& c)
 }
  
 
-void WordBench::Wordify(fsu::String& s)
+// n chars at ptr seen through the part of the String interface that
+// wordify() uses, so the rules run in place over a raw buffer
+class CharBuffer
+{
+public:
+  CharBuffer (char* ptr, size_t n) : ptr_(ptr), size_(n) {}
+  char   Element    (size_t i) const { return i < size_ ? ptr_[i] : '\0'; }
+  char&  operator[] (size_t i)       { return ptr_[i]; }
+  void   SetSize    (size_t n)       { size_ = n; }  // only ever shrinks here
+  size_t Size       () const         { return size_; }
+private:
+  char * ptr_;
+  size_t size_;
+};
+
+template < class S >  // S is fsu::String or CharBuffer
+void wordify(S& s)
 {
   // itr is a string's element counter
   // start is the element number where the word begins
@@ -197,4 +217,16 @@ void WordBench::Wordify(fsu::String& s)
     s.SetSize(stop);
     //    std::cout << "Cleaned word: " << s << std::endl;
     //}
+} // wordify()
+
+void WordBench::Wordify(fsu::String& s)
+{
+  wordify(s);
+}
+
+size_t WordBench::Wordify(char* s, size_t n)
+{
+  CharBuffer b(s, n);
+  wordify(b);
+  return b.Size();
 } // Wordify()